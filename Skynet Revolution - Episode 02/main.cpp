@@ -10,6 +10,12 @@
 #include <algorithm>
 #include <unordered_set>
 #include <unordered_map>
+#include <deque>
+#include <limits>
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -74,21 +80,29 @@ class Node
         }
         
         /**
-         * @returns A set containing all direct exits values.
+         * @returns The number of exits directly linked to this node.
          */
-        unordered_set<int> getAllDirectExits() 
+        int countDirectExits() const
         {
-            unordered_set<int> result;
+            int result = 0;
             
             for (auto c : m_children)
             {
                 if (c.second->isExit())
                 {
-                   result.insert(c.first);
+                   result++;
                 }
             }
             
-            return move(result);
+            return result;
+        }
+        
+        /**
+         * @returns Direct children of the node, indexed by their number.
+         */
+        const unordered_map<int, Node*>& getChildren() const
+        {
+            return m_children;
         }
         
         /**
@@ -117,210 +131,252 @@ class Node
         {
             return m_value;
         }
+
+    private :
+    
+        int m_value;
+        bool m_is_exit;
+        unordered_map<int, Node*> m_children;
+};
+
+/**
+ * This class describes how urgent it is to cut a gateway link.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class LinkUrgency
+{
+    public :
+        int slack;       // Turns left before the link must be cut : agent distance minus gateway links met along the way.
+        int exits_count; // Gateway links of the node that holds the link (the more, the more urgent).
+        int distance;    // Agent distance to the node that holds the link.
+
+        LinkUrgency() : slack(numeric_limits<int>::max()), exits_count(0), distance(numeric_limits<int>::max()) {}
+        LinkUrgency(int c_slack, int c_exits_count, int c_distance) : slack(c_slack), exits_count(c_exits_count), distance(c_distance) {}
+
+        bool operator <(const LinkUrgency& u) const
+        {
+            if (slack != u.slack)
+            {
+                return slack < u.slack;
+            }
+            else if (exits_count != u.exits_count)
+            {
+                return exits_count > u.exits_count;
+            }
+            else
+            {
+                return distance < u.distance;
+            }
+        }
+};
+
+
+/**
+ * Indexed binary heap of gateway links, the most urgent link being on top.
+ * Links are identified by a dense id given by the Network, which allows to update or remove any link in O(log n)
+ * without searching for it in the heap.
+ */
+class GatewayLinkQueue
+{
+    public :
+        /**
+         * Gateway link queue constructor.
+         */
+        GatewayLinkQueue() : m_heap(), m_positions(), m_urgencies() {}
+        
+        /**
+         * Gateway link queue destructor.
+         */
+        virtual ~GatewayLinkQueue() = default;
+        
+        /**
+         * @returns TRUE if no link is left in the queue, FALSE otherwise.
+         */
+        bool empty() const
+        {
+            return m_heap.empty();
+        }
+        
+        /**
+         * @param[in] link Link id to look for.
+         * 
+         * @returns TRUE if the link is in the queue, FALSE otherwise.
+         */
+        bool contains(int link) const
+        {
+            return link < (int)m_positions.size() && m_positions[link] != -1;
+        }
+        
+        /**
+         * @returns The id of the most urgent link. The queue must not be empty.
+         */
+        int top() const
+        {
+            return m_heap.front();
+        }
         
+        /**
+         * @param[in] link Link id, which must be in the queue.
+         * 
+         * @returns The current urgency of the link.
+         */
+        const LinkUrgency& getUrgency(int link) const
+        {
+            return m_urgencies[link];
+        }
         
         /**
-         * Optimized BFS algorithm taking into account the new problem constraints.
-         * If this node is not directly linked to an exit (in which case we need to cut this link now), the alogrithm acts as follow :
-         * 1 - It looks for the most critical "hot node" (i.e node leading to two exits or more) from the current node. 
-         *    The most critical hot node is the one that is the closest one in "normal" node count (i.e the one we have less time to cut off).
-         * 2 - If no hot node is left, we cut the closest edge leading to an exit.
+         * Inserts a link in the queue, or updates its urgency if it is already in it (decrease-key or increase-key).
          * 
-         * @returns A pair in which pair.first is the node previous to an exit and pair.second is an exit node. If no exit is left to cut,
-         *          the method returns a pair containing two NULLPTR.
+         * @param[in] link Link id.
+         * @param[in] urgency New urgency of the link.
          */
-        pair<Node*, Node*> getMostUrgentEdge()
+        void update(int link, const LinkUrgency &urgency)
         {
-            Node* direct_exit = getDirectExitNode();
-            
-            // Case in which this node is linked to an exit, we need to cut it now.
-            if (direct_exit != nullptr)
+            if (link >= (int)m_positions.size())
             {
-                return make_pair(this, direct_exit);
+                m_positions.resize(link+1, -1);
+                m_urgencies.resize(link+1);
             }
             
-            // Priority variables to make decisions about hot nodes.
-            int lowest_priority = numeric_limits<int>::max();
-            unordered_set<int> next_hot_nodes;
-            unordered_map<int, int> current_nodes_priorities;
-            unordered_map<int, int> next_nodes_priorities;
-            
-            // Classic BFS layer lists
-            unordered_set<int> walked_nodes;
-            unordered_map<int, Node*> current_layer;   
-            unordered_map<int, Node*> next_layer; 
-            
-            // First BFS layer is the curent node.
-            current_layer[m_value] = this;
-            walked_nodes.insert(m_value);
-            current_nodes_priorities[m_value] = 1;
-            
-            // We will reach end when no more node neeads to be investigated, 
-            // which means that we don't necessarily go through the whole graph to answer.
-            bool has_reached_end = false;
+            if (m_positions[link] == -1)
+            {
+                m_urgencies[link] = urgency;
+                m_positions[link] = m_heap.size();
+                m_heap.push_back(link);
+                siftUp(m_positions[link]);
+            }
+            else if (urgency < m_urgencies[link])
+            {
+                m_urgencies[link] = urgency;
+                siftUp(m_positions[link]);
+            }
+            else
+            {
+                m_urgencies[link] = urgency;
+                siftDown(m_positions[link]);
+            }
+        }
+        
+        /**
+         * Removes a link from the queue (if the link is in the queue, otherwise it does nothing).
+         * 
+         * @param[in] link Link id to remove.
+         */
+        void erase(int link)
+        {
+            if (!contains(link))
+            {
+                return;
+            }
             
-            // Answer if no hot node is found.
-            Node* default_exit_node = nullptr;
-            Node* default_prev_node_to_exit = nullptr;
+            int position = m_positions[link];
+            int last = m_heap.back();
             
-            // Answer if we find a hot node.
-            Node* hot_exit_node = nullptr;
-            Node* hot_prev_node_to_exit = nullptr;
+            m_heap.pop_back();
+            m_positions[link] = -1;
             
-            // BFS LOOP
-            while (!has_reached_end)
+            if (last != link)
+            {
+                m_heap[position] = last;
+                m_positions[last] = position;
+                siftUp(position);
+                siftDown(m_positions[last]);
+            }
+        }
+        
+    private :
+    
+        /**
+         * Moves up the heap entry at the given position until the heap property is restored.
+         * 
+         * @param[in] position Position in the heap array.
+         */
+        void siftUp(int position)
+        {
+            while (position > 0)
             {
-                // Filling in the next BFS layer
-                for (auto p : current_layer)
+                int parent = (position-1) / 2;
+                
+                if (!(m_urgencies[m_heap[position]] < m_urgencies[m_heap[parent]]))
                 {
-                    Node::addChildrenToLayer(p.second, walked_nodes, next_layer, current_nodes_priorities[p.first], next_nodes_priorities, next_hot_nodes);
+                    break;
                 }
                 
-                // As soon as we have an exit, we need to set the default node edge to cut,
-                // in case we don't find a hot node. 
-                if (default_exit_node == nullptr)
+                swapEntries(position, parent);
+                position = parent;
+            }
+        }
+        
+        /**
+         * Moves down the heap entry at the given position until the heap property is restored.
+         * 
+         * @param[in] position Position in the heap array.
+         */
+        void siftDown(int position)
+        {
+            int size = m_heap.size();
+            
+            while (true)
+            {
+                int smallest = position;
+                int left = 2*position + 1;
+                int right = left + 1;
+                
+                if (left < size && m_urgencies[m_heap[left]] < m_urgencies[m_heap[smallest]])
                 {
-                    for (auto p : next_layer)
-                    {
-                        default_exit_node = p.second->getDirectExitNode();
-                        
-                        if (default_exit_node != nullptr)
-                        {
-                            default_prev_node_to_exit = p.second;
-                            break;
-                        }
-                    }
+                    smallest = left;
                 }
                 
-                // If the next layer contains a hot node.
-                if (next_hot_nodes.size() > 0)
+                if (right < size && m_urgencies[m_heap[right]] < m_urgencies[m_heap[smallest]])
                 {
-                    // Let's check what hot nodes we found.
-                    for (int i : next_hot_nodes)
-                    {
-                        // If we found a hot node that is better in priority to the previous chosen one, we keep it for now.
-                        if (next_nodes_priorities[i] < lowest_priority)
-                        {
-                            lowest_priority = next_nodes_priorities[i];
-                            hot_prev_node_to_exit = next_layer[i];
-                            hot_exit_node = next_layer[i]->getDirectExitNode();
-                        }
-                        
-                        // In this algorithm, hot nodes are considered as exits (nodes we loose if reached), so they end 
-                        // their current path there.
-                        next_layer.erase(i);
-                        current_nodes_priorities.erase(i);
-                    }
-                    
-                    // For every other node in the layer that already has a worst priority than our lowest one,
-                    // no need to go any further for it, no way it can be chosen in the end, so we remove it
-                    // from the next iteration.
-                    for (auto p : next_nodes_priorities)
-                    {
-                        if (p.second > lowest_priority)
-                        {
-                            next_layer.erase(p.first);
-                            current_nodes_priorities.erase(p.first);
-                        }
-                    }
+                    smallest = right;
                 }
                 
-                // If the next BFS layer is empty, we can't go any further.
-                if (next_layer.size() == 0)
+                if (smallest == position)
                 {
-                    has_reached_end = true;
+                    break;
                 }
                 
-                // From one iteration to the other, the next_layer becomes the current one and it will restart from scratch at the next iteration.
-                current_layer = next_layer;
-                current_nodes_priorities = next_nodes_priorities;
-                next_nodes_priorities.clear();
-                next_hot_nodes.clear();
-                next_layer.clear();
-            }
-            
-            // In the end, either we can cut off from a hot node, or we cut the default edge we found. 
-            if (hot_exit_node != nullptr)
-            {
-                return make_pair(hot_prev_node_to_exit, hot_exit_node);
-            }
-            else
-            {
-                return make_pair(default_prev_node_to_exit, default_exit_node);
+                swapEntries(position, smallest);
+                position = smallest;
             }
         }
         
-    private :
-        
-        
         /**
-         *  getMostUrgentEdge() subMethod to add nodes to the next layer.
-         *  It adds children from a parent except if :
-         *   - They have already been walked through during a previous iteration.
-         *   - They are an exit.
-         *  All inserted children will be marked as walked through in the walked_nodes array.
-         * 
-         *  This method also updates priority data for the next layer so that decisions can be made in method getMostUrgentEdge().
-         * 
-         *  @param[in] node Parent node to add children from.
-         *  @param[inout] walked_nodes Already walked nodes during the BFS algorithm.
-         *  @param[inout] layer Layer to add children to.
-         *  @param[in] node_priority Priority of the parent node.node
-         *  @param[inout] node_priorities Priorities list to update with the retained children nodes.
-         *  @param[inout] hot_nodes List of hot nodes (i.e nodes leading to at least 2 exits) to update if we find hot nodes among children.
+         * Swaps two heap entries and keeps the positions index up to date.
          * 
+         * @param[in] a First position in the heap array.
+         * @param[in] b Second position in the heap array.
          */
-        static void addChildrenToLayer(const Node* node, unordered_set<int> &walked_nodes, unordered_map<int, Node*> &layer, int node_priority, unordered_map<int, int> &node_priorities, unordered_set<int> &hot_nodes)
+        void swapEntries(int a, int b)
         {
-            int child_exit_size = 0;
-            
-            for (auto p : node->m_children)
-            {
-                if (!p.second->isExit() && walked_nodes.find(p.first) == walked_nodes.end())
-                {
-                    walked_nodes.insert(p.first);
-                    layer[p.first] = p.second;
-                    child_exit_size = p.second->getAllDirectExits().size();
-                    
-                    
-                    if (child_exit_size == 0)
-                    {
-                        node_priorities[p.first] = node_priority + 1;
-                    }
-                    else
-                    {
-                        node_priorities[p.first] = node_priority;
-                        
-                        if (child_exit_size > 1)
-                        {
-                            hot_nodes.insert(p.first);
-                        }
-                    }
-                }
-            }
+            swap(m_heap[a], m_heap[b]);
+            m_positions[m_heap[a]] = a;
+            m_positions[m_heap[b]] = b;
         }
-    
-        int m_value;
-        bool m_is_exit;
-        unordered_map<int, Node*> m_children;
+        
+        vector<int> m_heap;                // Link ids, ordered as a binary heap on their urgency.
+        vector<int> m_positions;           // Link id => position in m_heap, or -1 if the link is not queued.
+        vector<LinkUrgency> m_urgencies;   // Link id => current urgency.
 };
 
 /**
- * This class decribes a Network graph.
+ * Network backend that stores the graph as Node objects linked through hash maps.
+ * It has no limit on node numbers, but walking it is dominated by hash lookups.
  */
-class Network
+class NodeGraph
 {
     public :
         /**
-         * Network constructor.
+         * Node graph constructor.
          */
-        Network() : m_nodes(){}
-        
+        NodeGraph() : m_nodes(), m_distances(), m_search_queue() {}
         
         /**
-         * Network destructor.
+         * Node graph destructor.
          */
-        virtual ~Network()
+        virtual ~NodeGraph()
         {
             for(auto p : m_nodes)
             {
@@ -351,64 +407,1965 @@ class Network
         }
         
         /**
-         * Marks a node as an exit in the network's graph.
+         * Cuts the edge between two nodes (if it exists, otherwise it does nothing).
+         * 
+         * @param[in] node_1_val First edge node number.
+         * @param[in] node_2_val Second edge node number.
+         */
+        void cutEdge(int node_1_val, int node_2_val)
+        {
+            Node* node_1 = getNode(node_1_val);
+            Node* node_2 = getNode(node_2_val);
+            
+            if (node_1 != nullptr && node_2 != nullptr)
+            {
+                node_1->cutEdge(node_2);
+                node_2->cutEdge(node_1);
+            }
+        }
+        
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns TRUE if the node is part of the graph, FALSE otherwise.
+         */
+        bool hasNode(int node_val) const
+        {
+            return m_nodes.find(node_val) != m_nodes.end();
+        }
+        
+        /**
+         * Marks a node as an exit (if the node exists, otherwise it does nothing).
          * 
          * @param[in] node_val Node number to mark as an exit.
          */
         void setExit(int node_val)
         {
-            unordered_map<int, Node*>::iterator search_res;
+            Node* node = getNode(node_val);
             
-            if ((search_res = m_nodes.find(node_val)) != m_nodes.end())
+            if (node != nullptr)
             {
-                search_res->second->setExit(true);
-            } 
+                node->setExit(true);
+            }
         }
         
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns TRUE if the node is an exit, FALSE otherwise.
+         */
+        bool isExit(int node_val) const
+        {
+            const Node* node = getNode(node_val);
+            
+            return node != nullptr && node->isExit();
+        }
         
         /**
-         * Removes the most urgent edge that leads to an exit in the graph and returns the resulting command for the virus to cut it.
-         * It removes either an edge on a node leading to two exit if the current agent position is not critical, or the closest edge
-         * leading to an exit otherwise.
+         * @param[in] node_val Node number.
          * 
-         * @param[in] agent_position Agent postion to start path finding from.
+         * @returns The number of one exit linked to the node, or -1 if the node is not linked to any exit.
+         */
+        int getDirectExit(int node_val) const
+        {
+            const Node* node = getNode(node_val);
+            Node* exit_node = (node != nullptr) ? const_cast<Node*>(node)->getDirectExitNode() : nullptr;
+            
+            return (exit_node != nullptr) ? exit_node->getValue() : -1;
+        }
+        
+        /**
+         * @param[in] node_val Node number.
          * 
-         * @returns A command that corresponds to the cut operated by the method, or "" if no cut was done.
+         * @returns The number of exits linked to the node.
          */
-        string cutPathToExit(int agent_position)
+        int countDirectExits(int node_val) const
         {
-            string result("");
+            const Node* node = getNode(node_val);
+            
+            return (node != nullptr) ? node->countDirectExits() : 0;
+        }
+        
+        /**
+         * Calls a function on every direct child of a node.
+         * 
+         * @param[in] node_val Node number.
+         * @param[in] function Function called with the number of each child.
+         */
+        template<class Function>
+        void forEachChild(int node_val, Function function) const
+        {
+            const Node* node = getNode(node_val);
             
-            Node* agent_node = m_nodes[agent_position];
+            if (node != nullptr)
+            {
+                for (auto c : node->getChildren())
+                {
+                    function(c.first);
+                }
+            }
+        }
+        
+        /**
+         * Calls a function on every node of the graph.
+         * 
+         * @param[in] function Function called with the number of each node.
+         */
+        template<class Function>
+        void forEachNode(Function function) const
+        {
+            for (auto p : m_nodes)
+            {
+                function(p.first);
+            }
+        }
+        
+        /**
+         * Walks the graph from the agent with a 0-1 BFS : walking through a node without exit costs one turn, walking through
+         * a node linked to one exit is free (the agent can be kept busy there by cutting that link), and nodes linked to
+         * several exits end their path, as they are lost if reached. Exits are never walked through.
+         * 
+         * @param[in] agent_val Node the agent is currently on.
+         * @param[in] on_exit_node Function called with (node number, node exits count, distance of the node parent) for every 
+         *                         walked node linked to an exit. Calls are made by non decreasing parent distance.
+         * @param[in] should_stop Function called with a distance before walking from a node at this distance. The walk stops 
+         *                        if it returns TRUE.
+         */
+        template<class OnExitNode, class ShouldStop>
+        void walkFromAgent(int agent_val, OnExitNode on_exit_node, ShouldStop should_stop)
+        {
+            m_distances.clear();
+            m_search_queue.clear();
             
-            pair<Node*, Node*> edge = agent_node->getMostUrgentEdge();
+            Node* agent_node = getNode(agent_val);
             
-            if (edge.first != nullptr && edge.second != nullptr) // We found an edge to cut.
+            if (agent_node == nullptr)
             {
-                result = to_string(edge.first->getValue())+" "+ to_string(edge.second->getValue());
-                edge.first->cutEdge(edge.second);
-                edge.second->cutEdge(edge.first);
+                return;
             }
             
-            return result;
+            m_distances[agent_val] = 0;
+            m_search_queue.push_back(agent_node);
+            
+            // 0-1 BFS LOOP
+            while (!m_search_queue.empty())
+            {
+                Node* node = m_search_queue.front();
+                m_search_queue.pop_front();
+                
+                int node_distance = m_distances[node->getValue()];
+                
+                if (should_stop(node_distance))
+                {
+                    break;
+                }
+                
+                for (auto c : node->getChildren())
+                {
+                    Node* child = c.second;
+                    
+                    if (child->isExit() || m_distances.find(c.first) != m_distances.end())
+                    {
+                        continue;
+                    }
+                    
+                    int exits_count = child->countDirectExits();
+                    
+                    if (exits_count == 0)
+                    {
+                        m_distances[c.first] = node_distance + 1;
+                        m_search_queue.push_back(child);
+                    }
+                    else
+                    {
+                        m_distances[c.first] = node_distance;
+                        on_exit_node(c.first, exits_count, node_distance);
+                        
+                        // Nodes linked to several exits are considered as exits, so they end their path there.
+                        if (exits_count == 1)
+                        {
+                            m_search_queue.push_front(child);
+                        }
+                    }
+                }
+            }
+        }
+        
+        /**
+         * Removes all nodes and edges from the graph.
+         */
+        void clear()
+        {
+            for(auto p : m_nodes)
+            {
+                delete p.second;
+            }
+            
+            m_nodes.clear();
         }
         
     private :
-        unordered_map<int, Node*> m_nodes;     
-};
-
-
-/**
- * Auto-generated code below aims at helping you parse
- * the standard input according to the problem statement.
- **/
-int main()
+    
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns The requested node, or NULLPTR if it doesn't exist.
+         */
+        Node* getNode(int node_val) const
+        {
+            auto search_res = m_nodes.find(node_val);
+            
+            return (search_res != m_nodes.end()) ? search_res->second : nullptr;
+        }
+        
+        unordered_map<int, Node*> m_nodes;
+        
+        // Buffers of the walk, kept from one call to the other.
+        unordered_map<int, int> m_distances;
+        deque<Node*> m_search_queue;
+};
+
+
+/**
+ * Row of bits used by the bit matrix backend, one bit per node. 
+ * Rows are padded to a multiple of 4 words and 32 bytes aligned so that row operations can work on 256 bits at once.
+ * This is a plain value type stored by value in the matrix : it has no virtual destructor, to keep rows vptr free.
+ */
+template<size_t MAX_NODES>
+class BitRow
+{
+    public :
+        static const int WORDS = ((MAX_NODES + 255) / 256) * 4;
+    
+        /**
+         * Bit row constructor, all bits are cleared.
+         */
+        BitRow() : m_words() {}
+        
+        void set(int bit)
+        {
+            m_words[bit >> 6] |= (uint64_t)1 << (bit & 63);
+        }
+        
+        void reset(int bit)
+        {
+            m_words[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+        }
+        
+        bool test(int bit) const
+        {
+            return (m_words[bit >> 6] >> (bit & 63)) & 1;
+        }
+        
+        void clear(int words)
+        {
+            fill(m_words, m_words + words, 0);
+        }
+        
+        /**
+         * @param[in] words Number of used words in the row (multiple of 4).
+         * 
+         * @returns TRUE if no bit is set among the used words.
+         */
+        bool none(int words) const
+        {
+            uint64_t result = 0;
+            
+            for (int i = 0; i < words; i++)
+            {
+                result |= m_words[i];
+            }
+            
+            return result == 0;
+        }
+        
+        /**
+         * @param[in] words Number of used words in the row (multiple of 4).
+         * @param[in] mask Row to intersect with.
+         * 
+         * @returns The number of bits set both in this row and the mask.
+         */
+        int countCommon(int words, const BitRow &mask) const
+        {
+            int result = 0;
+            
+            for (int i = 0; i < words; i++)
+            {
+                result += __builtin_popcountll(m_words[i] & mask.m_words[i]);
+            }
+            
+            return result;
+        }
+        
+        /**
+         * @param[in] words Number of used words in the row (multiple of 4).
+         * @param[in] mask Row to intersect with.
+         * 
+         * @returns The first bit set both in this row and the mask, or -1 if there is none.
+         */
+        int findFirstCommon(int words, const BitRow &mask) const
+        {
+            for (int i = 0; i < words; i++)
+            {
+                uint64_t common = m_words[i] & mask.m_words[i];
+                
+                if (common != 0)
+                {
+                    return (i << 6) + __builtin_ctzll(common);
+                }
+            }
+            
+            return -1;
+        }
+        
+        /**
+         * Row operation : this |= row.
+         * 
+         * @param[in] words Number of used words in the row (multiple of 4).
+         * @param[in] row Row to merge in this one.
+         */
+        void merge(int words, const BitRow &row)
+        {
+#ifdef __AVX2__
+            for (int i = 0; i < words; i += 4)
+            {
+                __m256i a = _mm256_loadu_si256((const __m256i*)(m_words + i));
+                __m256i b = _mm256_loadu_si256((const __m256i*)(row.m_words + i));
+                _mm256_storeu_si256((__m256i*)(m_words + i), _mm256_or_si256(a, b));
+            }
+#else
+            for (int i = 0; i < words; i++)
+            {
+                m_words[i] |= row.m_words[i];
+            }
+#endif
+        }
+        
+        /**
+         * Row operation : this &= ~row.
+         * 
+         * @param[in] words Number of used words in the row (multiple of 4).
+         * @param[in] row Row whose bits are removed from this one.
+         */
+        void remove(int words, const BitRow &row)
+        {
+#ifdef __AVX2__
+            for (int i = 0; i < words; i += 4)
+            {
+                __m256i a = _mm256_loadu_si256((const __m256i*)(m_words + i));
+                __m256i b = _mm256_loadu_si256((const __m256i*)(row.m_words + i));
+                _mm256_storeu_si256((__m256i*)(m_words + i), _mm256_andnot_si256(b, a));
+            }
+#else
+            for (int i = 0; i < words; i++)
+            {
+                m_words[i] &= ~row.m_words[i];
+            }
+#endif
+        }
+        
+        /**
+         * Calls a function on every set bit among the used words, in increasing order.
+         * 
+         * @param[in] words Number of used words in the row (multiple of 4).
+         * @param[in] function Function called with each set bit.
+         */
+        template<class Function>
+        void forEachBit(int words, Function function) const
+        {
+            for (int i = 0; i < words; i++)
+            {
+                uint64_t word = m_words[i];
+                
+                while (word != 0)
+                {
+                    function((i << 6) + __builtin_ctzll(word));
+                    word &= word - 1;
+                }
+            }
+        }
+        
+    private :
+        alignas(32) uint64_t m_words[WORDS];
+};
+
+
+/**
+ * Network backend that stores the graph as an adjacency bit matrix, for levels with at most MAX_NODES nodes numbered 
+ * from 0 to MAX_NODES-1. A whole BFS layer is expanded as an OR of the adjacency rows of its nodes, masked by the 
+ * nodes that were not walked yet.
+ */
+template<size_t MAX_NODES>
+class BitMatrixGraph
+{
+    public :
+        /**
+         * Bit matrix graph constructor.
+         */
+        BitMatrixGraph() : m_adjacency(MAX_NODES), m_exits(), m_nodes(), m_words(4), m_walked(), m_layer(), m_frontier(), m_reached() {}
+        
+        /**
+         * Bit matrix graph destructor.
+         */
+        virtual ~BitMatrixGraph() = default;
+        
+        /**
+         * Adds an edge to the graph. Node numbers out of the matrix are ignored.
+         * 
+         * @param[in] node_1_val First edge node number.
+         * @param[in] node_2_val Second edge node number.
+         */
+        void addEdge(int node_1_val, int node_2_val)
+        {
+            if (!isInMatrix(node_1_val) || !isInMatrix(node_2_val))
+            {
+                cerr << "Link " << node_1_val << " " << node_2_val << " ignored : the bit matrix network is limited to " << MAX_NODES << " nodes." << endl;
+                return;
+            }
+            
+            m_adjacency[node_1_val].set(node_2_val);
+            m_adjacency[node_2_val].set(node_1_val);
+            m_nodes.set(node_1_val);
+            m_nodes.set(node_2_val);
+            m_words = max(m_words, (max(node_1_val, node_2_val) / 256 + 1) * 4);
+        }
+        
+        /**
+         * Cuts the edge between two nodes (if it exists, otherwise it does nothing).
+         * 
+         * @param[in] node_1_val First edge node number.
+         * @param[in] node_2_val Second edge node number.
+         */
+        void cutEdge(int node_1_val, int node_2_val)
+        {
+            if (isInMatrix(node_1_val) && isInMatrix(node_2_val))
+            {
+                m_adjacency[node_1_val].reset(node_2_val);
+                m_adjacency[node_2_val].reset(node_1_val);
+            }
+        }
+        
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns TRUE if the node is part of the graph, FALSE otherwise.
+         */
+        bool hasNode(int node_val) const
+        {
+            return isInMatrix(node_val) && m_nodes.test(node_val);
+        }
+        
+        /**
+         * Marks a node as an exit (if the node exists, otherwise it does nothing).
+         * 
+         * @param[in] node_val Node number to mark as an exit.
+         */
+        void setExit(int node_val)
+        {
+            if (hasNode(node_val))
+            {
+                m_exits.set(node_val);
+            }
+        }
+        
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns TRUE if the node is an exit, FALSE otherwise.
+         */
+        bool isExit(int node_val) const
+        {
+            return isInMatrix(node_val) && m_exits.test(node_val);
+        }
+        
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns The number of one exit linked to the node, or -1 if the node is not linked to any exit.
+         */
+        int getDirectExit(int node_val) const
+        {
+            return hasNode(node_val) ? m_adjacency[node_val].findFirstCommon(m_words, m_exits) : -1;
+        }
+        
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns The number of exits linked to the node.
+         */
+        int countDirectExits(int node_val) const
+        {
+            return hasNode(node_val) ? m_adjacency[node_val].countCommon(m_words, m_exits) : 0;
+        }
+        
+        /**
+         * Calls a function on every direct child of a node.
+         * 
+         * @param[in] node_val Node number.
+         * @param[in] function Function called with the number of each child.
+         */
+        template<class Function>
+        void forEachChild(int node_val, Function function) const
+        {
+            if (hasNode(node_val))
+            {
+                m_adjacency[node_val].forEachBit(m_words, function);
+            }
+        }
+        
+        /**
+         * Calls a function on every node of the graph.
+         * 
+         * @param[in] function Function called with the number of each node.
+         */
+        template<class Function>
+        void forEachNode(Function function) const
+        {
+            m_nodes.forEachBit(m_words, function);
+        }
+        
+        /**
+         * Walks the graph from the agent layer by layer, with the same rules as NodeGraph::walkFromAgent() : nodes without exit
+         * cost one turn, nodes linked to one exit are free and nodes linked to several exits end their path.
+         * Each layer is expanded with row operations, and nodes linked to one exit are expanded again in the same layer.
+         * 
+         * @param[in] agent_val Node the agent is currently on.
+         * @param[in] on_exit_node Function called with (node number, node exits count, distance of the node parent) for every 
+         *                         walked node linked to an exit. Calls are made by non decreasing parent distance.
+         * @param[in] should_stop Function called with a distance before walking the layer at this distance. The walk stops 
+         *                        if it returns TRUE.
+         */
+        template<class OnExitNode, class ShouldStop>
+        void walkFromAgent(int agent_val, OnExitNode on_exit_node, ShouldStop should_stop)
+        {
+            if (!hasNode(agent_val))
+            {
+                return;
+            }
+            
+            m_walked.clear(m_words);
+            m_layer.clear(m_words);
+            m_walked.merge(m_words, m_exits);
+            m_walked.set(agent_val);
+            m_layer.set(agent_val);
+            
+            for (int distance = 0; !m_layer.none(m_words) && !should_stop(distance); distance++)
+            {
+                // Nodes without exit reached from this layer are walked at the next distance.
+                BitRow<MAX_NODES> next_layer;
+                m_frontier = m_layer;
+                
+                while (!m_frontier.none(m_words))
+                {
+                    m_reached.clear(m_words);
+                    m_frontier.forEachBit(m_words, [this](int node_val) { m_reached.merge(m_words, m_adjacency[node_val]); });
+                    m_reached.remove(m_words, m_walked);
+                    m_walked.merge(m_words, m_reached);
+                    m_frontier.clear(m_words);
+                    
+                    m_reached.forEachBit(m_words, [&](int node_val)
+                    {
+                        int exits_count = m_adjacency[node_val].countCommon(m_words, m_exits);
+                        
+                        if (exits_count == 0)
+                        {
+                            next_layer.set(node_val);
+                        }
+                        else
+                        {
+                            on_exit_node(node_val, exits_count, distance);
+                            
+                            // Nodes linked to several exits are considered as exits, so they end their path there.
+                            if (exits_count == 1)
+                            {
+                                m_frontier.set(node_val);
+                            }
+                        }
+                    });
+                }
+                
+                m_layer = next_layer;
+            }
+        }
+        
+        /**
+         * Removes all nodes and edges from the graph.
+         */
+        void clear()
+        {
+            m_nodes.forEachBit(m_words, [this](int node_val) { m_adjacency[node_val].clear(m_words); });
+            m_nodes.clear(m_words);
+            m_exits.clear(m_words);
+            m_words = 4;
+        }
+        
+    private :
+    
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns TRUE if the node number fits in the matrix.
+         */
+        static bool isInMatrix(int node_val)
+        {
+            return node_val >= 0 && node_val < (int)MAX_NODES;
+        }
+    
+        vector<BitRow<MAX_NODES>> m_adjacency; // Node number => row of its children.
+        BitRow<MAX_NODES> m_exits;
+        BitRow<MAX_NODES> m_nodes;
+        int m_words; // Number of words actually used in rows, depending on the highest node number.
+        
+        // Buffers of the walk, kept from one call to the other.
+        BitRow<MAX_NODES> m_walked;
+        BitRow<MAX_NODES> m_layer;
+        BitRow<MAX_NODES> m_frontier;
+        BitRow<MAX_NODES> m_reached;
+};
+
+
+/**
+ * Analyzer that computes the minimum set of links to cut so that the agent can't reach any exit anymore.
+ * It runs Dinic's max-flow from the agent to a super-sink linked to all exits, every link having a capacity of 1.
+ * 
+ * The flow network (vertices, arcs and capacities) is built once and kept from one turn to the other, along with the flow
+ * of the last analysis : cut links get their capacity set to 0 and their flow rerouted, and each analysis moves the flow
+ * to the new agent position before augmenting it with Dinic's algorithm.
+ */
+class CutFlowAnalyzer
+{
+    public :
+        /**
+         * Cut flow analyzer constructor.
+         */
+        CutFlowAnalyzer() : m_vertices(), m_values(), m_vertex_arcs(), m_arc_to(), m_arc_capacity(), m_arc_residual(), m_arcs_ids(), m_sink(-1), m_source(-1), 
+                            m_levels(), m_next_arcs(), m_distances(), m_parent_arcs(), m_search_queue() {}
+        
+        /**
+         * Cut flow analyzer destructor.
+         */
+        virtual ~CutFlowAnalyzer() = default;
+        
+        /**
+         * @returns TRUE if the flow network has already been built.
+         */
+        bool isBuilt() const
+        {
+            return m_sink != -1;
+        }
+        
+        /**
+         * Builds the flow network from a graph backend. It must be called once exits are known.
+         * 
+         * @param[in] graph Network graph backend.
+         */
+        template<class Graph>
+        void build(const Graph &graph)
+        {
+            graph.forEachNode([&](int node_val) { getVertex(node_val); });
+            
+            m_sink = m_values.size();
+            m_values.push_back(-1);
+            m_vertex_arcs.emplace_back();
+            
+            graph.forEachNode([&](int node_val)
+            {
+                if (graph.isExit(node_val))
+                {
+                    addArc(getVertex(node_val), m_sink, numeric_limits<int>::max(), 0);
+                    return;
+                }
+                
+                graph.forEachChild(node_val, [&](int child_val)
+                {
+                    if (graph.isExit(child_val))
+                    {
+                        // Agent never walks out of an exit, so the link only goes one way.
+                        addArc(getVertex(node_val), getVertex(child_val), 1, 0);
+                    }
+                    else if (node_val < child_val)
+                    {
+                        addArc(getVertex(node_val), getVertex(child_val), 1, 1);
+                    }
+                });
+            });
+            
+            m_arc_residual = m_arc_capacity;
+        }
+        
+        /**
+         * Removes a cut link from the flow network (if it exists, otherwise it does nothing).
+         * The flow of the last analysis is kept valid : the unit of flow that went through the link, if any, is rerouted 
+         * around it, or else sent back to the source and the super-sink.
+         * 
+         * @param[in] node_1_val First link node number.
+         * @param[in] node_2_val Second link node number.
+         */
+        void cutLink(int node_1_val, int node_2_val)
+        {
+            for (long long key : {getArcKey(node_1_val, node_2_val), getArcKey(node_2_val, node_1_val)})
+            {
+                auto search_res = m_arcs_ids.find(key);
+                
+                if (search_res != m_arcs_ids.end())
+                {
+                    int arc = search_res->second;
+                    int flow = m_arc_capacity[arc] - m_arc_residual[arc]; // Negative if the flow goes the reverse way.
+                    int from = flow >= 0 ? m_arc_to[arc ^ 1] : m_arc_to[arc];
+                    int to = flow >= 0 ? m_arc_to[arc] : m_arc_to[arc ^ 1];
+                    
+                    m_arc_capacity[arc] = 0;
+                    m_arc_capacity[arc ^ 1] = 0;
+                    m_arc_residual[arc] = 0;
+                    m_arc_residual[arc ^ 1] = 0;
+                    
+                    if (flow != 0 && !pushUnit(from, to))
+                    {
+                        pushUnit(from, m_source);
+                        pushUnit(m_sink, to);
+                    }
+                }
+            }
+        }
+        
+        /**
+         * Computes a minimum set of links separating the agent from all exits, and orders it by deadline. 
+         * The deadline of a link is the number of moves before the agent stands on its end, so the link must be cut at 
+         * the latest on the turn the agent arrives there. The layout is winnable if cutting links in this order meets
+         * every deadline (earliest deadline first).
+         * 
+         * @param[in] agent_position Node the agent is currently on.
+         * @param[out] schedule Links of the minimum cut (node on the agent side first), ordered by deadline.
+         * @param[out] deadlines Deadline of each link of the schedule.
+         * 
+         * @returns TRUE if the layout is winnable by following the schedule, FALSE otherwise.
+         */
+        bool analyze(int agent_position, vector<pair<int, int>> &schedule, vector<int> &deadlines)
+        {
+            schedule.clear();
+            deadlines.clear();
+            
+            auto search_res = m_vertices.find(agent_position);
+            
+            if (search_res == m_vertices.end())
+            {
+                return true;
+            }
+            
+            int source = search_res->second;
+            computeMaxFlow(source);
+            
+            // The last level graph contains the vertices still reachable from the agent : the cut is made of 
+            // the saturated links that leave them.
+            computeDistances(source);
+            vector<pair<int, pair<int, int>>> cut_links;
+            
+            for (int v = 0; v < (int)m_levels.size(); v++)
+            {
+                if (m_levels[v] == -1 || v == m_sink)
+                {
+                    continue;
+                }
+                
+                for (int arc : m_vertex_arcs[v])
+                {
+                    int to = m_arc_to[arc];
+                    
+                    if (m_arc_capacity[arc] > 0 && m_levels[to] == -1 && to != m_sink)
+                    {
+                        cut_links.push_back(make_pair(m_distances[v], make_pair(m_values[v], m_values[to])));
+                    }
+                }
+            }
+            
+            sort(cut_links.begin(), cut_links.end());
+            
+            bool is_winnable = true;
+            
+            for (int i = 0; i < (int)cut_links.size(); i++)
+            {
+                // The i-th cut is done on turn i+1, and a link whose end is at distance d must be cut by turn d+1.
+                if (cut_links[i].first == numeric_limits<int>::max() || i > cut_links[i].first)
+                {
+                    is_winnable = false;
+                }
+                
+                schedule.push_back(cut_links[i].second);
+                deadlines.push_back(cut_links[i].first);
+            }
+            
+            return is_winnable;
+        }
+        
+    private :
+    
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns The flow network vertex of the node, created if needed.
+         */
+        int getVertex(int node_val)
+        {
+            auto search_res = m_vertices.find(node_val);
+            
+            if (search_res != m_vertices.end())
+            {
+                return search_res->second;
+            }
+            
+            int vertex = m_values.size();
+            
+            m_vertices[node_val] = vertex;
+            m_values.push_back(node_val);
+            m_vertex_arcs.emplace_back();
+            
+            return vertex;
+        }
+        
+        /**
+         * Adds an arc and its reverse arc (stored at the next id, so that reverse(arc) == arc ^ 1).
+         * 
+         * @param[in] from Arc start vertex.
+         * @param[in] to Arc end vertex.
+         * @param[in] capacity Arc capacity.
+         * @param[in] reverse_capacity Reverse arc capacity.
+         */
+        void addArc(int from, int to, int capacity, int reverse_capacity)
+        {
+            int arc = m_arc_to.size();
+            
+            m_arc_to.push_back(to);
+            m_arc_capacity.push_back(capacity);
+            m_vertex_arcs[from].push_back(arc);
+            
+            m_arc_to.push_back(from);
+            m_arc_capacity.push_back(reverse_capacity);
+            m_vertex_arcs[to].push_back(arc + 1);
+            
+            if (to != m_sink)
+            {
+                m_arcs_ids[getArcKey(m_values[from], m_values[to])] = arc;
+            }
+        }
+        
+        /**
+         * Dinic's algorithm from the agent to the super-sink, warm started from the flow of the last analysis.
+         * The units of flow that left the previous agent vertex are moved to the new one when a residual path joins them,
+         * and sent back to the super-sink otherwise. The flow is then augmented from the new agent vertex.
+         * 
+         * @param[in] source Agent vertex.
+         * 
+         * @returns The max flow, i.e the size of the minimum cut.
+         */
+        int computeMaxFlow(int source)
+        {
+            m_levels.assign(m_values.size(), -1);
+            m_next_arcs.assign(m_values.size(), 0);
+            
+            if (m_source != -1 && m_source != source)
+            {
+                for (int outflow = getOutflow(m_source); outflow > 0; outflow--)
+                {
+                    if (!pushUnit(source, m_source))
+                    {
+                        pushUnit(m_sink, m_source);
+                    }
+                }
+            }
+            
+            m_source = source;
+            
+            while (buildLevels(source))
+            {
+                fill(m_next_arcs.begin(), m_next_arcs.end(), 0);
+                
+                while (pushFlow(source, numeric_limits<int>::max()) > 0) {}
+            }
+            
+            return getOutflow(source);
+        }
+        
+        /**
+         * @param[in] v A vertex.
+         * 
+         * @returns The net flow leaving the vertex.
+         */
+        int getOutflow(int v) const
+        {
+            int outflow = 0;
+            
+            for (int arc : m_vertex_arcs[v])
+            {
+                outflow += m_arc_capacity[arc] - m_arc_residual[arc];
+            }
+            
+            return outflow;
+        }
+        
+        /**
+         * Pushes one unit of flow along a shortest path of the residual network.
+         * 
+         * @param[in] from Path start vertex.
+         * @param[in] to Path end vertex.
+         * 
+         * @returns TRUE if a path was found, FALSE otherwise (the flow is left unchanged).
+         */
+        bool pushUnit(int from, int to)
+        {
+            m_parent_arcs.assign(m_values.size(), -1);
+            m_search_queue.clear();
+            
+            m_parent_arcs[from] = numeric_limits<int>::max(); // Walked, with no parent arc.
+            m_search_queue.push_back(from);
+            
+            while (!m_search_queue.empty() && m_parent_arcs[to] == -1)
+            {
+                int v = m_search_queue.front();
+                m_search_queue.pop_front();
+                
+                for (int arc : m_vertex_arcs[v])
+                {
+                    int next = m_arc_to[arc];
+                    
+                    if (m_arc_residual[arc] > 0 && m_parent_arcs[next] == -1)
+                    {
+                        m_parent_arcs[next] = arc;
+                        m_search_queue.push_back(next);
+                    }
+                }
+            }
+            
+            if (m_parent_arcs[to] == -1)
+            {
+                return false;
+            }
+            
+            for (int v = to; v != from; v = m_arc_to[m_parent_arcs[v] ^ 1])
+            {
+                m_arc_residual[m_parent_arcs[v]]--;
+                m_arc_residual[m_parent_arcs[v] ^ 1]++;
+            }
+            
+            return true;
+        }
+        
+        /**
+         * Computes the BFS level of every vertex in the residual network.
+         * 
+         * @param[in] source Agent vertex.
+         * 
+         * @returns TRUE if the super-sink is reachable.
+         */
+        bool buildLevels(int source)
+        {
+            fill(m_levels.begin(), m_levels.end(), -1);
+            m_search_queue.clear();
+            
+            m_levels[source] = 0;
+            m_search_queue.push_back(source);
+            
+            while (!m_search_queue.empty())
+            {
+                int v = m_search_queue.front();
+                m_search_queue.pop_front();
+                
+                for (int arc : m_vertex_arcs[v])
+                {
+                    int to = m_arc_to[arc];
+                    
+                    if (m_arc_residual[arc] > 0 && m_levels[to] == -1)
+                    {
+                        m_levels[to] = m_levels[v] + 1;
+                        m_search_queue.push_back(to);
+                    }
+                }
+            }
+            
+            return m_levels[m_sink] != -1;
+        }
+        
+        /**
+         * Pushes a blocking flow along the level graph.
+         * 
+         * @param[in] v Current vertex.
+         * @param[in] pushed Flow that can still be pushed to this vertex.
+         * 
+         * @returns The flow that reached the super-sink.
+         */
+        int pushFlow(int v, int pushed)
+        {
+            if (v == m_sink)
+            {
+                return pushed;
+            }
+            
+            for (int &i = m_next_arcs[v]; i < (int)m_vertex_arcs[v].size(); i++)
+            {
+                int arc = m_vertex_arcs[v][i];
+                int to = m_arc_to[arc];
+                
+                if (m_arc_residual[arc] > 0 && m_levels[to] == m_levels[v] + 1)
+                {
+                    int flow = pushFlow(to, min(pushed, m_arc_residual[arc]));
+                    
+                    if (flow > 0)
+                    {
+                        m_arc_residual[arc] -= flow;
+                        m_arc_residual[arc ^ 1] += flow;
+                        
+                        return flow;
+                    }
+                }
+            }
+            
+            return 0;
+        }
+        
+        /**
+         * Computes the number of moves the agent needs to reach every node, on alive links and without walking through exits.
+         * 
+         * @param[in] source Agent vertex.
+         */
+        void computeDistances(int source)
+        {
+            m_distances.assign(m_values.size(), numeric_limits<int>::max());
+            m_search_queue.clear();
+            
+            m_distances[source] = 0;
+            m_search_queue.push_back(source);
+            
+            while (!m_search_queue.empty())
+            {
+                int v = m_search_queue.front();
+                m_search_queue.pop_front();
+                
+                for (int arc : m_vertex_arcs[v])
+                {
+                    int to = m_arc_to[arc];
+                    
+                    // Arcs going to exits have no reverse capacity, and exits only lead to the super-sink.
+                    if (m_arc_capacity[arc] > 0 && m_arc_capacity[arc ^ 1] > 0 && m_distances[to] == numeric_limits<int>::max())
+                    {
+                        m_distances[to] = m_distances[v] + 1;
+                        m_search_queue.push_back(to);
+                    }
+                }
+            }
+        }
+        
+        /**
+         * @param[in] from_val Arc start node number.
+         * @param[in] to_val Arc end node number.
+         * 
+         * @returns The key of the arc in m_arcs_ids.
+         */
+        static long long getArcKey(int from_val, int to_val)
+        {
+            return ((long long)from_val << 32) | (unsigned int)to_val;
+        }
+    
+        unordered_map<int, int> m_vertices;   // Node number => vertex.
+        vector<int> m_values;                 // Vertex => node number (-1 for the super-sink).
+        vector<vector<int>> m_vertex_arcs;    // Vertex => arcs leaving it.
+        vector<int> m_arc_to;                 // Arc => end vertex.
+        vector<int> m_arc_capacity;           // Arc => capacity (0 once the link is cut).
+        vector<int> m_arc_residual;           // Arc => residual capacity, i.e capacity minus the flow of the last analysis.
+        unordered_map<long long, int> m_arcs_ids; // Arc key => arc.
+        int m_sink;
+        int m_source;                         // Agent vertex of the last analysis (-1 before the first one).
+        
+        // Buffers of the analysis, kept from one turn to the other.
+        vector<int> m_levels;
+        vector<int> m_next_arcs;
+        vector<int> m_distances;
+        vector<int> m_parent_arcs;
+        deque<int> m_search_queue;
+};
+
+
+/**
+ * Finder of the bridges of the network, i.e the links whose cut splits the agent's reachable area in two.
+ * Exits are left out of the analysed graph since the agent can't walk through them, so cutting a bridge isolates all 
+ * the gateway links hanging behind it at once.
+ * 
+ * Bridges are computed once with Tarjan's algorithm, along with the 2-edge-connected components they separate. 
+ * Cutting a bridge doesn't change any other bridge, and cutting another link can only create bridges inside its own 
+ * component, so cuts are handled by running Tarjan's algorithm again on that component only.
+ */
+class BridgeFinder
+{
+    public :
+        /**
+         * Bridge finder constructor.
+         */
+        BridgeFinder() : m_vertices(), m_values(), m_vertex_edges(), m_edge_ends(), m_edge_alive(), m_edge_bridge(), m_edges_ids(), m_components(), m_components_count(0), m_is_built(false), m_order(), m_low(), m_counter(0), m_dfs_stack(), m_parents(), m_search_queue() {}
+        
+        /**
+         * Bridge finder destructor.
+         */
+        virtual ~BridgeFinder() = default;
+        
+        /**
+         * @returns TRUE if the bridges have already been computed.
+         */
+        bool isBuilt() const
+        {
+            return m_is_built;
+        }
+        
+        /**
+         * Computes the bridges of a graph backend. It must be called once exits are known.
+         * 
+         * @param[in] graph Network graph backend.
+         */
+        template<class Graph>
+        void build(const Graph &graph)
+        {
+            graph.forEachNode([&](int node_val)
+            {
+                if (!graph.isExit(node_val))
+                {
+                    getVertex(node_val);
+                }
+            });
+            
+            graph.forEachNode([&](int node_val)
+            {
+                graph.forEachChild(node_val, [&](int child_val)
+                {
+                    if (node_val < child_val && !graph.isExit(node_val) && !graph.isExit(child_val))
+                    {
+                        addEdge(getVertex(node_val), getVertex(child_val));
+                    }
+                });
+            });
+            
+            m_components.assign(m_values.size(), -1);
+            computeBridges(-1);
+            m_is_built = true;
+        }
+        
+        /**
+         * Removes a cut link from the analysed graph and updates bridges (if the link exists, otherwise it does nothing).
+         * 
+         * @param[in] node_1_val First link node number.
+         * @param[in] node_2_val Second link node number.
+         */
+        void cutLink(int node_1_val, int node_2_val)
+        {
+            auto search_res = m_edges_ids.find(getEdgeKey(node_1_val, node_2_val));
+            
+            if (search_res == m_edges_ids.end() || !m_edge_alive[search_res->second])
+            {
+                return;
+            }
+            
+            int edge = search_res->second;
+            m_edge_alive[edge] = false;
+            
+            if (!m_edge_bridge[edge])
+            {
+                computeBridges(m_components[m_edge_ends[edge].first]);
+            }
+        }
+        
+        /**
+         * Looks for the first bridge crossed on the way from the agent to a node. Since every path between them crosses the
+         * same bridges, cutting the first one also cuts the agent from everything behind it.
+         * 
+         * @param[in] agent_position Node the agent is currently on.
+         * @param[in] node_val Node to reach.
+         * @param[out] bridge First bridge crossed (node on the agent side first), if any.
+         * 
+         * @returns TRUE if a bridge separates the agent from the node, FALSE otherwise.
+         */
+        bool findFirstBridge(int agent_position, int node_val, pair<int, int> &bridge)
+        {
+            auto agent_res = m_vertices.find(agent_position);
+            auto node_res = m_vertices.find(node_val);
+            
+            if (agent_res == m_vertices.end() || node_res == m_vertices.end() 
+                || m_components[agent_res->second] == m_components[node_res->second])
+            {
+                return false;
+            }
+            
+            int source = agent_res->second;
+            int target = node_res->second;
+            
+            // BFS from the agent, keeping the edge used to reach each vertex.
+            m_parents.assign(m_values.size(), -1);
+            m_search_queue.clear();
+            m_search_queue.push_back(source);
+            m_parents[source] = numeric_limits<int>::max();
+            
+            while (!m_search_queue.empty() && m_parents[target] == -1)
+            {
+                int v = m_search_queue.front();
+                m_search_queue.pop_front();
+                
+                for (auto &p : m_vertex_edges[v])
+                {
+                    if (m_edge_alive[p.second] && m_parents[p.first] == -1)
+                    {
+                        m_parents[p.first] = p.second;
+                        m_search_queue.push_back(p.first);
+                    }
+                }
+            }
+            
+            if (m_parents[target] == -1)
+            {
+                return false;
+            }
+            
+            // Walking the path back, the last bridge met is the first one from the agent.
+            bool found = false;
+            
+            for (int v = target; v != source; )
+            {
+                int edge = m_parents[v];
+                int prev = (m_edge_ends[edge].first == v) ? m_edge_ends[edge].second : m_edge_ends[edge].first;
+                
+                if (m_edge_bridge[edge])
+                {
+                    bridge = make_pair(m_values[prev], m_values[v]);
+                    found = true;
+                }
+                
+                v = prev;
+            }
+            
+            return found;
+        }
+        
+    private :
+    
+        /**
+         * @param[in] node_val Node number.
+         * 
+         * @returns The vertex of the node, created if needed.
+         */
+        int getVertex(int node_val)
+        {
+            auto search_res = m_vertices.find(node_val);
+            
+            if (search_res != m_vertices.end())
+            {
+                return search_res->second;
+            }
+            
+            int vertex = m_values.size();
+            
+            m_vertices[node_val] = vertex;
+            m_values.push_back(node_val);
+            m_vertex_edges.emplace_back();
+            
+            return vertex;
+        }
+        
+        /**
+         * Adds an edge between two vertices.
+         * 
+         * @param[in] v First vertex.
+         * @param[in] w Second vertex.
+         */
+        void addEdge(int v, int w)
+        {
+            int edge = m_edge_ends.size();
+            
+            m_edge_ends.push_back(make_pair(v, w));
+            m_edge_alive.push_back(true);
+            m_edge_bridge.push_back(false);
+            m_vertex_edges[v].push_back(make_pair(w, edge));
+            m_vertex_edges[w].push_back(make_pair(v, edge));
+            m_edges_ids[getEdgeKey(m_values[v], m_values[w])] = edge;
+        }
+        
+        /**
+         * Runs Tarjan's algorithm on one 2-edge-connected component (or on the whole graph), then splits it in new 
+         * components along the bridges found.
+         * 
+         * @param[in] component Component to work on, or -1 for the whole graph.
+         */
+        void computeBridges(int component)
+        {
+            m_order.assign(m_values.size(), -1);
+            m_low.assign(m_values.size(), 0);
+            m_counter = 0;
+            
+            for (int v = 0; v < (int)m_values.size(); v++)
+            {
+                if (m_order[v] == -1 && m_components[v] == component)
+                {
+                    visit(v, component);
+                }
+            }
+            
+            // New components are the areas left connected without crossing any bridge.
+            for (int v = 0; v < (int)m_values.size(); v++)
+            {
+                if (m_components[v] != component || m_order[v] == -2)
+                {
+                    continue;
+                }
+                
+                int new_component = m_components_count++;
+                
+                m_search_queue.clear();
+                m_search_queue.push_back(v);
+                m_order[v] = -2;
+                
+                while (!m_search_queue.empty())
+                {
+                    int u = m_search_queue.front();
+                    m_search_queue.pop_front();
+                    m_components[u] = new_component;
+                    
+                    for (auto &p : m_vertex_edges[u])
+                    {
+                        if (m_edge_alive[p.second] && !m_edge_bridge[p.second] && m_order[p.first] != -2)
+                        {
+                            m_order[p.first] = -2;
+                            m_search_queue.push_back(p.first);
+                        }
+                    }
+                }
+            }
+        }
+        
+        /**
+         * Tarjan's algorithm DFS : marks as bridges the tree edges that no back edge goes over.
+         * The DFS uses its own stack, since large levels would overflow the call stack.
+         * 
+         * @param[in] root DFS root vertex.
+         * @param[in] component Component being worked on.
+         */
+        void visit(int root, int component)
+        {
+            // Stack of (vertex, edge used to reach it, next edge index to look at).
+            m_dfs_stack.clear();
+            m_dfs_stack.push_back(make_pair(make_pair(root, -1), 0));
+            m_order[root] = m_low[root] = m_counter++;
+            
+            while (!m_dfs_stack.empty())
+            {
+                int v = m_dfs_stack.back().first.first;
+                int parent_edge = m_dfs_stack.back().first.second;
+                int &i = m_dfs_stack.back().second;
+                
+                if (i < (int)m_vertex_edges[v].size())
+                {
+                    int w = m_vertex_edges[v][i].first;
+                    int edge = m_vertex_edges[v][i].second;
+                    i++;
+                    
+                    if (!m_edge_alive[edge] || edge == parent_edge || m_components[w] != component)
+                    {
+                        continue;
+                    }
+                    
+                    if (m_order[w] == -1)
+                    {
+                        m_order[w] = m_low[w] = m_counter++;
+                        m_dfs_stack.push_back(make_pair(make_pair(w, edge), 0));
+                    }
+                    else
+                    {
+                        m_low[v] = min(m_low[v], m_order[w]);
+                    }
+                }
+                else
+                {
+                    m_dfs_stack.pop_back();
+                    
+                    if (parent_edge != -1)
+                    {
+                        int u = m_dfs_stack.back().first.first;
+                        
+                        m_low[u] = min(m_low[u], m_low[v]);
+                        m_edge_bridge[parent_edge] = m_low[v] > m_order[u];
+                    }
+                }
+            }
+        }
+        
+        /**
+         * @param[in] node_1_val First link node number.
+         * @param[in] node_2_val Second link node number.
+         * 
+         * @returns The key of the link in m_edges_ids, whatever the order of its nodes.
+         */
+        static long long getEdgeKey(int node_1_val, int node_2_val)
+        {
+            return ((long long)min(node_1_val, node_2_val) << 32) | (unsigned int)max(node_1_val, node_2_val);
+        }
+    
+        unordered_map<int, int> m_vertices;         // Node number => vertex.
+        vector<int> m_values;                       // Vertex => node number.
+        vector<vector<pair<int, int>>> m_vertex_edges; // Vertex => (neighbour vertex, edge).
+        vector<pair<int, int>> m_edge_ends;         // Edge => its two vertices.
+        vector<bool> m_edge_alive;                  // Edge => FALSE once cut.
+        vector<bool> m_edge_bridge;                 // Edge => TRUE if it is a bridge.
+        unordered_map<long long, int> m_edges_ids;  // Link key => edge.
+        vector<int> m_components;                   // Vertex => 2-edge-connected component.
+        int m_components_count;
+        bool m_is_built;
+        
+        // Buffers of the searches.
+        vector<int> m_order;
+        vector<int> m_low;
+        int m_counter;
+        vector<pair<pair<int, int>, int>> m_dfs_stack;
+        vector<int> m_parents;
+        deque<int> m_search_queue;
+};
+
+
+/**
+ * Node orders the network can relabel its nodes with (see Network::reorderNodes()).
+ */
+enum NodeOrdering{INPUT_ORDER, GATEWAYS_BFS, REVERSE_CUTHILL_MCKEE};
+
+
+/**
+ * This class decribes a Network graph, and decides which gateway link to cut.
+ * The graph itself is stored by a backend (NodeGraph or BitMatrixGraph).
+ */
+template<class Graph>
+class Network
+{
+    public :
+        /**
+         * Network constructor.
+         */
+        Network() : m_graph(), m_internal_ids(), m_external_ids(), m_links(), m_links_ids(), m_links_stamps(), m_links_queue(), m_node_links_counts(), 
+                    m_links_counts_nodes(1, 0), m_max_links_count(0), m_turn(0), m_bridge_finder()
+#ifdef SKYNET_FLOW_ANALYSIS
+                  , m_flow_analyzer(), m_cuts_schedule(), m_cuts_deadlines()
+#endif
+        {}
+        
+        
+        /**
+         * Network destructor.
+         */
+        virtual ~Network() = default;
+        
+        /**
+         * Adds an edge to the graph, adding also nodes along the way if they don't already exist.
+         * 
+         * @param[in] node_1_val First edge node number.
+         * @param[in] node_2_val Second edge node number.
+         */
+        void addEdge(int node_1_val, int node_2_val)
+        {            
+            m_graph.addEdge(node_1_val, node_2_val);
+        }
+        
+        /**
+         * Marks a node as an exit in the network's graph, and queues all the gateway links it creates.
+         * 
+         * @param[in] node_val Node number to mark as an exit.
+         */
+        void setExit(int node_val)
+        {
+            if (m_graph.hasNode(node_val))
+            {
+                m_graph.setExit(node_val);
+                m_graph.forEachChild(node_val, [&](int child_val)
+                {
+                    if (m_graph.isExit(child_val))
+                    {
+                        // A link between two exits can't be walked by the agent, it doesn't need to be cut.
+                        unregisterLink(node_val, child_val);
+                    }
+                    else
+                    {
+                        registerLink(child_val, node_val);
+                    }
+                });
+            } 
+        }
+        
+        
+        /**
+         * Relabels the nodes so that nodes walked together are stored close to each other, which keeps the graph walks
+         * cache friendly on large levels. Node numbers given to and returned by the network remain the input ones.
+         * It must be called once the graph and its exits are set, before the first turn.
+         * 
+         * @param[in] ordering Order in which nodes are relabelled.
+         */
+        void reorderNodes(NodeOrdering ordering)
+        {
+            if (ordering == NodeOrdering::INPUT_ORDER)
+            {
+                return;
+            }
+            
+            // Snapshot of the current graph, with current labels.
+            unordered_map<int, vector<int>> adjacency;
+            vector<int> exits;
+            
+            m_graph.forEachNode([&](int node_val)
+            {
+                vector<int> &children = adjacency[node_val];
+                m_graph.forEachChild(node_val, [&](int child_val) { children.push_back(child_val); });
+                
+                if (m_graph.isExit(node_val))
+                {
+                    exits.push_back(node_val);
+                }
+            });
+            
+            vector<int> order = (ordering == NodeOrdering::GATEWAYS_BFS) ? computeBfsOrder(adjacency, exits, false) 
+                                                                         : computeBfsOrder(adjacency, vector<int>(), true);
+            
+            unordered_map<int, int> new_labels;
+            vector<int> external_ids(order.size());
+            
+            for (int i = 0; i < (int)order.size(); i++)
+            {
+                new_labels[order[i]] = i;
+                external_ids[i] = toExternal(order[i]);
+            }
+            
+            // Rebuilding the graph and its gateway links with the new labels.
+            m_graph.clear();
+            m_links.clear();
+            m_links_ids.clear();
+            m_links_stamps.clear();
+            m_links_queue = GatewayLinkQueue();
+            m_node_links_counts.clear();
+            m_links_counts_nodes.assign(1, 0);
+            m_max_links_count = 0;
+            
+            for (int node_val : order)
+            {
+                for (int child_val : adjacency[node_val])
+                {
+                    if (new_labels[node_val] < new_labels[child_val])
+                    {
+                        m_graph.addEdge(new_labels[node_val], new_labels[child_val]);
+                    }
+                }
+            }
+            
+            for (int exit_val : exits)
+            {
+                setExit(new_labels[exit_val]);
+            }
+            
+            m_external_ids = move(external_ids);
+            m_internal_ids.clear();
+            
+            for (int i = 0; i < (int)m_external_ids.size(); i++)
+            {
+                m_internal_ids[m_external_ids[i]] = i;
+            }
+        }
+        
+        /**
+         * Removes the most urgent edge that leads to an exit in the graph and returns the resulting command for the virus to cut it.
+         * If the agent is directly linked to an exit, this link is cut. Otherwise the gateway links urgencies are refreshed
+         * around the agent position and the most urgent one is popped from the links queue. If a bridge separates the agent
+         * from that link, the first such bridge is cut instead : it neutralises the link and every other one behind it.
+         * 
+         * In flow analysis mode (SKYNET_FLOW_ANALYSIS defined), the minimum cut between the agent and the exits is computed
+         * first : if it can be cut in time, its link with the earliest deadline is cut instead.
+         * 
+         * @param[in] agent_position Agent postion to start path finding from.
+         * 
+         * @returns A command that corresponds to the cut operated by the method, or "" if no cut was done.
+         */
+        string cutPathToExit(int agent_position)
+        {
+            string result("");
+            agent_position = toInternal(agent_position);
+            
+            int direct_exit = m_graph.getDirectExit(agent_position);
+            pair<int, int> edge(-1, -1);
+            
+            if (direct_exit != -1) // Case in which the agent is linked to an exit, we need to cut it now.
+            {
+                edge = make_pair(agent_position, direct_exit);
+            }
+#ifdef SKYNET_FLOW_ANALYSIS
+            else if (analyzeCuts(agent_position))
+            {
+                edge = m_cuts_schedule.front();
+            }
+#endif
+            else if (!m_links_queue.empty())
+            {
+                refreshLinksUrgency(agent_position);
+                edge = m_links[m_links_queue.top()];
+                
+                if (!m_bridge_finder.isBuilt())
+                {
+                    m_bridge_finder.build(m_graph);
+                }
+                
+                pair<int, int> bridge;
+                
+                if (m_bridge_finder.findFirstBridge(agent_position, edge.first, bridge))
+                {
+                    edge = bridge;
+                }
+            }
+            
+            if (edge.first != -1 && edge.second != -1) // We found an edge to cut.
+            {
+                result = to_string(toExternal(edge.first))+" "+ to_string(toExternal(edge.second));
+                m_graph.cutEdge(edge.first, edge.second);
+                unregisterLink(edge.first, edge.second);
+                m_bridge_finder.cutLink(edge.first, edge.second);
+#ifdef SKYNET_FLOW_ANALYSIS
+                m_flow_analyzer.cutLink(edge.first, edge.second);
+#endif
+            }
+            
+            return result;
+        }
+        
+    private :
+    
+#ifdef SKYNET_FLOW_ANALYSIS
+        /**
+         * Runs the flow analysis from the agent position (the flow network is built on the first call).
+         * 
+         * @param[in] agent_position Node the agent is currently on.
+         * 
+         * @returns TRUE if the minimum cut can be cut in time, in which case m_cuts_schedule holds the links to cut in order.
+         */
+        bool analyzeCuts(int agent_position)
+        {
+            if (!m_flow_analyzer.isBuilt())
+            {
+                m_flow_analyzer.build(m_graph);
+            }
+            
+            bool is_winnable = m_flow_analyzer.analyze(agent_position, m_cuts_schedule, m_cuts_deadlines);
+            
+            cerr << "Flow analysis : " << m_cuts_schedule.size() << " link(s) to cut, " << (is_winnable ? "winnable" : "NOT winnable") << " :";
+            
+            for (int i = 0; i < (int)m_cuts_schedule.size(); i++)
+            {
+                cerr << " [" << toExternal(m_cuts_schedule[i].first) << " " << toExternal(m_cuts_schedule[i].second) << " d=" << m_cuts_deadlines[i] << "]";
+            }
+            
+            cerr << endl;
+            
+            return is_winnable && !m_cuts_schedule.empty();
+        }
+#endif
+
+        /**
+         * Orders nodes by BFS, component by component.
+         * 
+         * @param[in] adjacency Node number => children numbers.
+         * @param[in] sources Nodes the BFS starts from all at once (the remaining components start from their smallest node).
+         * @param[in] reverse_cuthill_mckee TRUE to follow Reverse Cuthill-McKee : each component starts from a node of minimum 
+         *                                  degree, children are walked by increasing degree and the final order is reversed.
+         * 
+         * @returns Node numbers, in their new order.
+         */
+        static vector<int> computeBfsOrder(unordered_map<int, vector<int>> &adjacency, const vector<int> &sources, bool reverse_cuthill_mckee)
+        {
+            vector<int> nodes, order;
+            unordered_set<int> walked_nodes;
+            
+            for (auto &p : adjacency)
+            {
+                nodes.push_back(p.first);
+                
+                if (reverse_cuthill_mckee)
+                {
+                    sort(p.second.begin(), p.second.end(), [&](int a, int b)
+                    {
+                        return make_pair(adjacency[a].size(), a) < make_pair(adjacency[b].size(), b);
+                    });
+                }
+            }
+            
+            sort(nodes.begin(), nodes.end(), [&](int a, int b)
+            {
+                return reverse_cuthill_mckee ? make_pair(adjacency[a].size(), a) < make_pair(adjacency[b].size(), b) : a < b;
+            });
+            
+            vector<int> starts(sources);
+            sort(starts.begin(), starts.end());
+            
+            for (int i = -1; i < (int)nodes.size(); i++)
+            {
+                if (i >= 0)
+                {
+                    if (walked_nodes.find(nodes[i]) != walked_nodes.end())
+                    {
+                        continue;
+                    }
+                    
+                    starts.assign(1, nodes[i]);
+                }
+                
+                size_t head = order.size();
+                
+                for (int start : starts)
+                {
+                    if (walked_nodes.insert(start).second)
+                    {
+                        order.push_back(start);
+                    }
+                }
+                
+                // The order vector is the BFS queue itself.
+                for (; head < order.size(); head++)
+                {
+                    for (int child_val : adjacency[order[head]])
+                    {
+                        if (walked_nodes.insert(child_val).second)
+                        {
+                            order.push_back(child_val);
+                        }
+                    }
+                }
+            }
+            
+            if (reverse_cuthill_mckee)
+            {
+                reverse(order.begin(), order.end());
+            }
+            
+            return order;
+        }
+        
+        /**
+         * @param[in] node_val Input node number.
+         * 
+         * @returns The node number used in the graph.
+         */
+        int toInternal(int node_val) const
+        {
+            if (m_external_ids.empty())
+            {
+                return node_val;
+            }
+            
+            auto search_res = m_internal_ids.find(node_val);
+            
+            return (search_res != m_internal_ids.end()) ? search_res->second : -1;
+        }
+        
+        /**
+         * @param[in] node_val Node number used in the graph.
+         * 
+         * @returns The input node number.
+         */
+        int toExternal(int node_val) const
+        {
+            return m_external_ids.empty() ? node_val : m_external_ids[node_val];
+        }
+    
+        /**
+         * Updates the urgency of the gateway links around the agent, so that the most urgent link is on top of the links queue.
+         * 
+         * The graph is walked from the agent (see NodeGraph::walkFromAgent()), and the slack of a link is the distance of its 
+         * node minus the number of exits linked to this node.
+         * 
+         * The walk stops as soon as no node left to reach can beat the most urgent link found so far, so the links that 
+         * were not reached keep their previous urgency. Those outdated links are only raised to the walk lower bound 
+         * when they come on top of the queue.
+         * 
+         * @param[in] agent_position Node the agent is currently on.
+         */
+        void refreshLinksUrgency(int agent_position)
+        {
+            m_turn++;
+            
+            int max_exits_count = m_max_links_count;
+            
+            int best_slack = numeric_limits<int>::max();
+            int lower_bound = numeric_limits<int>::max();
+            
+            m_graph.walkFromAgent(agent_position,
+                [&](int node_val, int exits_count, int parent_distance)
+                {
+                    LinkUrgency urgency(parent_distance + 1 - exits_count, exits_count, parent_distance + 1);
+                    
+                    best_slack = min(best_slack, urgency.slack);
+                    
+                    m_graph.forEachChild(node_val, [&](int child_val)
+                    {
+                        if (m_graph.isExit(child_val))
+                        {
+                            int link = m_links_ids[getLinkKey(node_val, child_val)];
+                            m_links_queue.update(link, urgency);
+                            m_links_stamps[link] = m_turn;
+                        }
+                    });
+                },
+                [&](int distance)
+                {
+                    // Nothing left to reach can be more urgent than the best link found so far.
+                    if (best_slack != numeric_limits<int>::max() && distance + 1 - max_exits_count > best_slack)
+                    {
+                        lower_bound = distance + 1 - max_exits_count;
+                        return true;
+                    }
+                    
+                    return false;
+                });
+            
+            // Outdated links on top of the queue can't be more urgent than the walk lower bound.
+            while (m_links_stamps[m_links_queue.top()] != m_turn)
+            {
+                int link = m_links_queue.top();
+                
+                m_links_queue.update(link, LinkUrgency(lower_bound, 0, numeric_limits<int>::max()));
+                m_links_stamps[link] = m_turn;
+            }
+        }
+        
+        /**
+         * Registers a gateway link and queues it.
+         * 
+         * @param[in] node_val Number of the node linked to the exit.
+         * @param[in] exit_val Number of the exit.
+         */
+        void registerLink(int node_val, int exit_val)
+        {
+            long long key = getLinkKey(node_val, exit_val);
+            
+            if (m_links_ids.find(key) == m_links_ids.end())
+            {
+                int link = m_links.size();
+                
+                m_links_ids[key] = link;
+                m_links.push_back(make_pair(node_val, exit_val));
+                m_links_stamps.push_back(0);
+                m_links_queue.update(link, LinkUrgency());
+                updateLinksCount(node_val, 1);
+            }
+        }
+        
+        /**
+         * Unregisters a gateway link and removes it from the queue (if the link exists, otherwise it does nothing).
+         * 
+         * @param[in] node_val Number of the node linked to the exit.
+         * @param[in] exit_val Number of the exit.
+         */
+        void unregisterLink(int node_val, int exit_val)
+        {
+            auto search_res = m_links_ids.find(getLinkKey(node_val, exit_val));
+            
+            if (search_res != m_links_ids.end())
+            {
+                m_links_queue.erase(search_res->second);
+                m_links[search_res->second] = make_pair(-1, -1);
+                m_links_ids.erase(search_res);
+                updateLinksCount(node_val, -1);
+            }
+        }
+        
+        /**
+         * Updates the number of alive gateway links of a node, and the highest such number among all nodes.
+         * The highest number can only drop by one when a link is cut, so it is kept up to date in O(1) with the
+         * number of nodes per links count.
+         * 
+         * @param[in] node_val Number of the node linked to the exit.
+         * @param[in] delta 1 when a link of the node is registered, -1 when it is unregistered.
+         */
+        void updateLinksCount(int node_val, int delta)
+        {
+            int &links_count = m_node_links_counts[node_val];
+            
+            if (links_count > 0)
+            {
+                m_links_counts_nodes[links_count]--;
+            }
+            
+            links_count += delta;
+            
+            if (links_count >= (int)m_links_counts_nodes.size())
+            {
+                m_links_counts_nodes.push_back(0);
+            }
+            
+            if (links_count > 0)
+            {
+                m_links_counts_nodes[links_count]++;
+            }
+            
+            if (links_count > m_max_links_count)
+            {
+                m_max_links_count = links_count;
+            }
+            else if (m_max_links_count > 0 && m_links_counts_nodes[m_max_links_count] == 0)
+            {
+                m_max_links_count--;
+            }
+        }
+        
+        /**
+         * @param[in] node_val Number of the node linked to the exit.
+         * @param[in] exit_val Number of the exit.
+         * 
+         * @returns The key of the gateway link in m_links_ids.
+         */
+        static long long getLinkKey(int node_val, int exit_val)
+        {
+            return ((long long)node_val << 32) | (unsigned int)exit_val;
+        }
+    
+        Graph m_graph;
+        unordered_map<int, int> m_internal_ids;     // Input node number => graph node number, empty if nodes were not reordered.
+        vector<int> m_external_ids;                 // Graph node number => input node number, empty if nodes were not reordered.
+        
+        vector<pair<int, int>> m_links;             // Link id => (node, exit), or (-1, -1) if the link has been cut.
+        unordered_map<long long, int> m_links_ids;  // Link key => link id, for links that are still alive.
+        vector<int> m_links_stamps;                 // Link id => last turn its urgency was refreshed.
+        GatewayLinkQueue m_links_queue;             // Alive links, the most urgent one on top.
+        unordered_map<int, int> m_node_links_counts; // Node number => alive gateway links of the node.
+        vector<int> m_links_counts_nodes;           // Alive gateway links count => nodes with that count (0 is not counted).
+        int m_max_links_count;                      // Highest alive gateway links count of a node.
+        int m_turn;
+        BridgeFinder m_bridge_finder;               // Alternate candidates : bridges cutting several gateway links at once.
+        
+#ifdef SKYNET_FLOW_ANALYSIS
+        CutFlowAnalyzer m_flow_analyzer;
+        vector<pair<int, int>> m_cuts_schedule;     // Minimum cut links ordered by deadline, from the last analysis.
+        vector<int> m_cuts_deadlines;
+#endif
+};
+
+
+// Define SKYNET_FLOW_ANALYSIS to run the min-cut analysis every turn (reported on the error output) and follow its 
+// schedule whenever the layout is winnable.
+
+// Order nodes are relabelled with once the level is loaded (see Network::reorderNodes()). On both backends, the gateways
+// BFS order plays turns a few percent faster than the input order, and more on large levels (see SKYNET_BENCHMARK).
+#ifndef SKYNET_NODE_ORDERING
+#define SKYNET_NODE_ORDERING GATEWAYS_BFS
+#endif
+
+// Network backend selection. Official levels have at most 500 nodes, so the bit matrix backend is used by default, and
+// levels with more than SKYNET_BIT_MATRIX_MAX_NODES nodes fall back to the hash map backend.
+// Define SKYNET_NODE_GRAPH to always use the hash map backend.
+#ifndef SKYNET_BIT_MATRIX_MAX_NODES
+#define SKYNET_BIT_MATRIX_MAX_NODES 1024
+#endif
+
+
+/**
+ * Reads the level links and gateways, then plays the game on the given network backend.
+ * 
+ * @param[in] L The number of links.
+ * @param[in] E The number of exit gateways.
+ */
+template<class Graph>
+void playGame(int L, int E)
 {
-    int N; // the total number of nodes in the level, including the gateways
-    int L; // the number of links
-    int E; // the number of exit gateways
-    cin >> N >> L >> E; cin.ignore();
-    Network game_network;
+    Network<Graph> game_network;
     
     for (int i = 0; i < L; i++) 
     {
@@ -426,6 +2383,8 @@ int main()
         game_network.setExit(EI);
     }
     
+    game_network.reorderNodes(NodeOrdering::SKYNET_NODE_ORDERING);
+    
     // game loop
     while (1) 
     {
@@ -434,4 +2393,223 @@ int main()
 
         cout << game_network.cutPathToExit(SI) << endl;
     }
-}
\ No newline at end of file
+}
+
+
+#ifdef SKYNET_BENCHMARK
+// ============================================================================
+//                              LATENCY BENCHMARK
+// ============================================================================
+// Define SKYNET_BENCHMARK to build a latency benchmark instead of the Codingame program : seeded random levels are loaded
+// in each network backend with each node ordering, then the same turns are played on all of them from random agent
+// positions. Usage :
+//      ./benchmark [nodes] [levels] [turns] [layout] [seed]
+// Layout 0 is a random tree with two more links per node, layout 1 a square grid. Node labels are shuffled, and there is
+// a gateway every 25 nodes. The bit matrix backend is skipped on levels with more than SKYNET_BIT_MATRIX_MAX_NODES nodes.
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <numeric>
+
+/**
+ * Level of the benchmark.
+ * It's ok to let the fields public here, the level is only generated and loaded.
+ */
+class BenchmarkLevel
+{
+    public :
+        int nodes_count;
+        vector<pair<int, int>> links;
+        vector<int> exits;
+        vector<int> agent_positions;    // Agent position of each turn.
+
+        BenchmarkLevel() : nodes_count(0), links(), exits(), agent_positions() {}
+        ~BenchmarkLevel() = default;
+
+        /**
+         * Generates a level.
+         * 
+         * @param[in] random Random generator.
+         * @param[in] c_nodes_count Number of nodes (rounded down to a square for grids).
+         * @param[in] layout 0 for a random tree with two more links per node, 1 for a square grid.
+         * @param[in] turns Number of turns to play.
+         */
+        void generate(mt19937 &random, int c_nodes_count, int layout, int turns)
+        {
+            int side = max(2, (int)sqrt((double)c_nodes_count));
+            nodes_count = layout == 1 ? side * side : max(2, c_nodes_count);
+            
+            vector<int> labels(nodes_count);
+            iota(labels.begin(), labels.end(), 0);
+            shuffle(labels.begin(), labels.end(), random);
+            
+            links.clear();
+            
+            for (int v = 0; v < nodes_count; v++)
+            {
+                if (layout == 1)
+                {
+                    if (v % side + 1 < side) links.push_back(make_pair(labels[v], labels[v+1]));
+                    if (v + side < nodes_count) links.push_back(make_pair(labels[v], labels[v+side]));
+                }
+                else
+                {
+                    if (v > 0) links.push_back(make_pair(labels[v], labels[random() % v]));
+                    
+                    for (int k = 0; k < 2; k++)
+                    {
+                        int w = random() % nodes_count;
+                        
+                        if (w != v) links.push_back(make_pair(labels[v], labels[w]));
+                    }
+                }
+            }
+            
+            shuffle(links.begin(), links.end(), random);
+            
+            vector<bool> is_exit(nodes_count, false);
+            exits.clear();
+            
+            for (int k = 0; k < max(1, nodes_count / 25); k++)
+            {
+                int exit_val = random() % nodes_count;
+                
+                if (!is_exit[exit_val])
+                {
+                    is_exit[exit_val] = true;
+                    exits.push_back(exit_val);
+                }
+            }
+            
+            agent_positions.clear();
+            
+            while ((int)agent_positions.size() < turns)
+            {
+                int position = random() % nodes_count;
+                
+                if (!is_exit[position])
+                {
+                    agent_positions.push_back(position);
+                }
+            }
+        }
+};
+
+/**
+ * Loads a level in a network and plays its turns.
+ * 
+ * @param[in] level Level to play.
+ * @param[in] ordering Node ordering of the network.
+ * @param[out] turn_latencies Latency of each turn, in microseconds (appended).
+ */
+template<class Graph>
+void playBenchmarkLevel(const BenchmarkLevel &level, NodeOrdering ordering, vector<double> &turn_latencies)
+{
+    Network<Graph> network;
+    
+    for (const pair<int, int> &link : level.links)
+    {
+        network.addEdge(link.first, link.second);
+    }
+    
+    for (int exit_val : level.exits)
+    {
+        network.setExit(exit_val);
+    }
+    
+    network.reorderNodes(ordering);
+    
+    for (int position : level.agent_positions)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        string cut = network.cutPathToExit(position);
+        turn_latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+}
+
+/**
+ * Latency benchmark entry point.
+ **/
+int main(int argc, char** argv)
+{
+    int nodes_count = argc > 1 ? atoi(argv[1]) : 500;
+    int levels = argc > 2 ? atoi(argv[2]) : 20;
+    int turns = argc > 3 ? atoi(argv[3]) : 50;
+    int layout = argc > 4 ? atoi(argv[4]) : 0;
+    unsigned seed = argc > 5 ? (unsigned)atoi(argv[5]) : 0;
+    
+    static const char* backend_names[2] = {"hash map", "bit matrix"};
+    static const char* ordering_names[3] = {"input order", "gateways BFS", "reverse Cuthill-McKee"};
+    vector<double> turn_latencies[2][3];
+    
+    for (int level_index = 0; level_index < levels; level_index++)
+    {
+        mt19937 random(seed + level_index);
+        BenchmarkLevel level;
+        level.generate(random, nodes_count, layout, turns);
+        
+        for (int ordering = NodeOrdering::INPUT_ORDER; ordering <= NodeOrdering::REVERSE_CUTHILL_MCKEE; ordering++)
+        {
+            playBenchmarkLevel<NodeGraph>(level, (NodeOrdering)ordering, turn_latencies[0][ordering]);
+            
+            if (level.nodes_count <= SKYNET_BIT_MATRIX_MAX_NODES)
+            {
+                playBenchmarkLevel<BitMatrixGraph<SKYNET_BIT_MATRIX_MAX_NODES>>(level, (NodeOrdering)ordering, turn_latencies[1][ordering]);
+            }
+        }
+    }
+    
+    for (int backend = 0; backend < 2; backend++)
+    {
+        double input_order_mean = 0.0;
+        
+        for (int ordering = 0; ordering < 3; ordering++)
+        {
+            vector<double> &latencies = turn_latencies[backend][ordering];
+            
+            if (latencies.empty())
+            {
+                continue;
+            }
+            
+            sort(latencies.begin(), latencies.end());
+            double mean = accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+            input_order_mean = ordering == NodeOrdering::INPUT_ORDER ? mean : input_order_mean;
+            
+            cout << backend_names[backend] << ", " << ordering_names[ordering] << " : turn (us) mean " << mean 
+                 << " p50 " << latencies[latencies.size() / 2] << " p99 " << latencies[min(latencies.size() - 1, latencies.size() * 99 / 100)]
+                 << " speedup vs input order " << input_order_mean / mean << endl;
+        }
+    }
+    
+    return 0;
+}
+#else
+
+/**
+ * Auto-generated code below aims at helping you parse
+ * the standard input according to the problem statement.
+ **/
+int main()
+{
+    int N; // the total number of nodes in the level, including the gateways
+    int L; // the number of links
+    int E; // the number of exit gateways
+    cin >> N >> L >> E; cin.ignore();
+    
+#ifdef SKYNET_NODE_GRAPH
+    playGame<NodeGraph>(L, E);
+#else
+    if (N > SKYNET_BIT_MATRIX_MAX_NODES)
+    {
+        cerr << N << " nodes : the bit matrix network is limited to " << SKYNET_BIT_MATRIX_MAX_NODES << " nodes, the hash map network is used." << endl;
+        playGame<NodeGraph>(L, E);
+    }
+    else
+    {
+        playGame<BitMatrixGraph<SKYNET_BIT_MATRIX_MAX_NODES>>(L, E);
+    }
+#endif
+}
+#endif
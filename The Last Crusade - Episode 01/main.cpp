@@ -215,6 +215,27 @@ class Tile
             }
         }
 
+        /**
+         * Gives the output direction for an input on the current tile.
+         *
+         * @param[in] input The direction from which the character enters the tile.
+         * @param[out] output The direction by which the character leaves the tile.
+         *
+         * @returns TRUE if the character can enter the tile from this direction, FALSE otherwise.
+         */
+        bool getOutputDirection(Direction input, Direction &output) const
+        {
+            map<Direction,Direction>::const_iterator it_path = m_paths.find(input);
+
+            if (it_path == m_paths.end())
+            {
+                return false;
+            }
+
+            output = it_path->second;
+            return true;
+        }
+
     private:
 
         /**
@@ -320,7 +341,7 @@ class Map
         /**
             Map constructor.
         **/
-        Map() : m_size(0,0), m_mapping() {}
+        Map() : m_size(0,0), m_mapping(), m_next() {}
 
         /**
             Map destructor. Nothing special because tiles will auto destruct there (they are not pointers).
@@ -345,6 +366,35 @@ class Map
 
             m_size.x = max(m_size.x, x+1);
             m_size.y = max(m_size.y, y+1);
+
+            m_next.clear(); // Transitions must be compiled again.
+        }
+
+        /**
+         * Compiles the transitions of the map : tiles never rotate in this episode, so the next state of every (tile, input)
+         * state is computed once. States are numbered (y * map width + x) * 4 + input direction.
+         */
+        void compileTransitions()
+        {
+            m_next.assign(m_size.x * m_size.y * 4, -1);
+
+            for (map<Vector2i, Tile>::iterator it_tile = m_mapping.begin(); it_tile != m_mapping.end(); it_tile++)
+            {
+                Vector2i position = it_tile->first;
+
+                for (int input = Direction::TOP; input <= Direction::LEFT; input++)
+                {
+                    Direction output;
+                    Tile* next_tile = it_tile->second.getOutputTile((Direction)input);
+
+                    if (next_tile != nullptr && it_tile->second.getOutputDirection((Direction)input, output))
+                    {
+                        Vector2i next_position = next_tile->getPosition();
+
+                        m_next[getState(position.x, position.y, (Direction)input)] = getState(next_position.x, next_position.y, getReversedDirection(output));
+                    }
+                }
+            }
         }
 
         /**
@@ -358,21 +408,98 @@ class Map
          */
         Vector2i getNextPlayerPosition(int x, int y, Direction input)
         {
-            Tile* nextTile = m_mapping[Vector2i(x,y)].getOutputTile(input);
+            if (m_next.empty())
+            {
+                compileTransitions();
+            }
 
-            if (nextTile != nullptr)
+            int next_state = m_next[getState(x, y, input)];
+
+            if (next_state >= 0)
             {
-                return nextTile->getPosition();
+                return getStatePosition(next_state);
             }
             else
             {
-                cerr << "Cell (" << x << "," << y << ") - Type:" << m_mapping[Vector2i(x,y)].getType() << " - Enter:" << input << " >> NO NEXT" << endl;
+                cerr << "Cell (" << x << "," << y << ") - Enter:" << input << " >> NO NEXT" << endl;
                 return Vector2i(x,y); // cannot move
             }
         }
 
+        /**
+         * Replays the whole fall of a player through the map, from a tile to the last one it can reach.
+         *
+         * @param[in] x Player position on tiles line.
+         * @param[in] y Player position on tiles column.
+         * @param[in] input Direction by which the player is coming in the tile.
+         * @param[out] fall_path Positions of the tiles the player goes through, the starting one included.
+         *
+         * @returns Number of tiles in the fall path.
+         */
+        int replayFall(int x, int y, Direction input, vector<Vector2i> &fall_path)
+        {
+            if (m_next.empty())
+            {
+                compileTransitions();
+            }
+
+            fall_path.clear();
+
+            // The player never goes up nor back in a line, so there are at most as many steps as tiles.
+            for (int state = getState(x, y, input); state >= 0 && fall_path.size() <= m_mapping.size(); state = m_next[state])
+            {
+                fall_path.push_back(getStatePosition(state));
+            }
+
+            return fall_path.size();
+        }
+
     private :
 
+        /**
+         * @param[in] x Position on tiles line.
+         * @param[in] y Position on tiles column.
+         * @param[in] input Direction by which the player is coming in the tile.
+         *
+         * @returns The state number : (y * map width + x) * 4 + input.
+         */
+        int getState(int x, int y, Direction input) const
+        {
+            return (y * m_size.x + x) * 4 + input;
+        }
+
+        /**
+         * @param[in] state A state number (see getState()).
+         *
+         * @returns The position of the tile of the state.
+         */
+        Vector2i getStatePosition(int state) const
+        {
+            int tile_index = state / 4;
+
+            return Vector2i(tile_index % m_size.x, tile_index / m_size.x);
+        }
+
+        /**
+         * @param[in] direction A direction the player leaves a tile by.
+         *
+         * @returns The direction the player enters the next tile by.
+         */
+        static Direction getReversedDirection(Direction direction)
+        {
+            switch (direction)
+            {
+                case Direction::TOP :
+                    return Direction::BOTTOM;
+                case Direction::RIGHT :
+                    return Direction::LEFT;
+                case Direction::LEFT :
+                    return Direction::RIGHT;
+                default :
+                    return Direction::TOP;
+            }
+        }
+
         /**
          * Updates the neighborhood of a new tile and all the tiles touching it currently, so that the grid remains 
          * consistent in the mapping.
@@ -440,6 +567,7 @@ class Map
 
         Vector2i m_size;
         map<Vector2i, Tile> m_mapping;
+        vector<int> m_next; // State => next state, or -1 if the player can't move on (see compileTransitions()).
 };
 
 /**
@@ -508,6 +636,8 @@ int main()
         }
     }
 
+    level_map.compileTransitions(); // Tiles never move : each turn is then a single table lookup.
+
 
     // ========================================================================
     //                              GAME LOOP
@@ -14,6 +14,12 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <queue>
+#include <limits>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
 
 using namespace std;
 
@@ -80,12 +86,227 @@ template<>
     {
         size_t operator()(const Vector2i& obj) const
         {
-            return hash<string>()(obj.x+"|"+obj.y);
+            return hash<long long>()(((long long)obj.y << 32) ^ (unsigned int)obj.x);
         }
     };
 }
 
 
+/**
+ * This class holds the paths of every tile type under every rotation, and the rotations worth trying on it. Everything is
+ * computed at compile time from the sides each type connects, with the game's gravity : a side is never left by TOP nor
+ * entered by BOTTOM, the BOTTOM side wins when it is connected, and an input with two other connected sides is a dead end.
+ */
+class TileOrientations
+{
+    public :
+
+        /**
+            Tile orientations constructor : computes the tables.
+        **/
+        constexpr TileOrientations() : connections
+            {
+                0,
+                link(TOP, RIGHT) | link(TOP, BOTTOM) | link(TOP, LEFT) | link(RIGHT, BOTTOM) | link(RIGHT, LEFT) | link(BOTTOM, LEFT),
+                link(LEFT, RIGHT),
+                link(TOP, BOTTOM),
+                link(TOP, LEFT) | link(RIGHT, BOTTOM),
+                link(TOP, RIGHT) | link(LEFT, BOTTOM),
+                link(LEFT, RIGHT) | link(TOP, LEFT) | link(TOP, RIGHT),
+                link(TOP, BOTTOM) | link(TOP, RIGHT) | link(RIGHT, BOTTOM),
+                link(LEFT, RIGHT) | link(LEFT, BOTTOM) | link(RIGHT, BOTTOM),
+                link(TOP, BOTTOM) | link(TOP, LEFT) | link(LEFT, BOTTOM),
+                link(TOP, LEFT),
+                link(TOP, RIGHT),
+                link(RIGHT, BOTTOM),
+                link(LEFT, BOTTOM),
+                link(TOP, RIGHT) | link(TOP, BOTTOM) | link(TOP, LEFT) | link(RIGHT, BOTTOM) | link(RIGHT, LEFT) | link(BOTTOM, LEFT)
+            }, paths(), distinct_quarters(), blocking_quarters()
+        {
+            for (int type = TileType::TYPE0; type <= TileType::EXIT; type++)
+            {
+                for (int rotation = 0; rotation < 4; rotation++)
+                {
+                    for (int input = 0; input < 4; input++)
+                    {
+                        // Sides of the original orientation are moved clockwise by the rotation.
+                        int original_input = (input + 4 - rotation) % 4;
+                        int candidates_count = 0, output = -1;
+                        bool bottom = false;
+
+                        for (int side = 0; side < 4 && input != Direction::BOTTOM; side++)
+                        {
+                            if (side != Direction::TOP && side != input && (connections[type] & link(original_input, (side + 4 - rotation) % 4)) != 0)
+                            {
+                                candidates_count++;
+                                output = side;
+                                bottom = bottom || side == Direction::BOTTOM;
+                            }
+                        }
+
+                        paths[type][rotation][input] = bottom ? Direction::BOTTOM : (candidates_count == 1 ? output : -1);
+                    }
+                }
+
+                // Rotations in the order the solvers try them, i.e by cost : DIRECT, LEFT, RIGHT, LEFT LEFT.
+                const int quarters_order[4] = {0, 3, 1, 2};
+
+                for (int i = 0; i < 4; i++)
+                {
+                    distinct_quarters[type][quarters_order[i]] = true;
+
+                    for (int j = 0; j < i; j++)
+                    {
+                        distinct_quarters[type][quarters_order[i]] = distinct_quarters[type][quarters_order[i]] && !haveSamePaths(type, quarters_order[i], quarters_order[j]);
+                    }
+                }
+
+                // A turn blocks a rock if the rock can't enter anymore, and the player (if any) still goes out by the same side.
+                for (int rotation = 0; rotation < 4; rotation++)
+                {
+                    for (int rock_entry = 0; rock_entry < 4; rock_entry++)
+                    {
+                        for (int player_entry = -1; player_entry < 4; player_entry++)
+                        {
+                            for (int quarters = 1; quarters < 4; quarters++)
+                            {
+                                int turned = (rotation + quarters) % 4;
+                                bool blocks = paths[type][turned][rock_entry] < 0
+                                              && (player_entry < 0 || paths[type][turned][player_entry] == paths[type][rotation][player_entry]);
+
+                                blocking_quarters[type][rotation][rock_entry][player_entry + 1] |= blocks ? 1 << quarters : 0;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * @returns TRUE if a tile type has the same paths under two rotations.
+         */
+        constexpr bool haveSamePaths(int type, int rotation, int other_rotation) const
+        {
+            bool same = true;
+
+            for (int input = 0; input < 4; input++)
+            {
+                same = same && paths[type][rotation][input] == paths[type][other_rotation][input];
+            }
+
+            return same;
+        }
+
+        /**
+         * Gives the turns of a tile that stop a rock, while keeping the path of the player going through the tile.
+         *
+         * @param[in] type Tile type.
+         * @param[in] rotation Current rotation of the tile, in quarters clockwise from the original orientation.
+         * @param[in] rock_entry Direction the rock enters the tile by.
+         * @param[in] player_entry Direction the player enters the tile by, or -1 if the tile isn't on the player path.
+         *
+         * @returns The turns blocking the rock, bit q set for q quarters clockwise from the current rotation (1 to 3).
+         */
+        constexpr int blockingRotations(int type, int rotation, int rock_entry, int player_entry) const
+        {
+            return blocking_quarters[type][rotation][rock_entry][player_entry + 1];
+        }
+
+        /**
+         * Checks the tables by brute force : the paths of a rotation follow the connections of the type with every side turned
+         * clockwise, a tile turned a quarter right has the paths of the type the game turns it into, and a rotation is
+         * distinct iff no cheaper one gives the same paths.
+         *
+         * @returns TRUE if the tables are consistent.
+         */
+        constexpr bool check() const
+        {
+            const int right_of[TileType::EXIT + 1] = {0, 1, 3, 2, 5, 4, 7, 8, 9, 6, 11, 12, 13, 10, TileType::EXIT};
+            const int quarters_cost[4] = {0, 1, 2, 1};
+            bool consistent = true;
+
+            for (int type = TileType::TYPE0; type <= TileType::EXIT; type++)
+            {
+                int rotated_type = type;
+
+                for (int rotation = 0; rotation < 4; rotation++)
+                {
+                    bool cheaper_twin = false;
+                    int turned_connections = 0;
+
+                    for (int side = 0; side < 4; side++)
+                    {
+                        for (int other_side = 0; other_side < 4; other_side++)
+                        {
+                            turned_connections |= (connections[type] & link(side, other_side)) != 0 ? link((side + rotation) % 4, (other_side + rotation) % 4) : 0;
+                        }
+                    }
+
+                    for (int input = 0; input < 4; input++)
+                    {
+                        int output = paths[type][rotation][input];
+                        int exits_count = 0;
+
+                        for (int side = Direction::RIGHT; side < 4 && input != Direction::BOTTOM; side++)
+                        {
+                            exits_count += side != input && (turned_connections & link(input, side)) != 0 ? 1 : 0;
+                        }
+
+                        bool to_bottom = input != Direction::BOTTOM && (turned_connections & link(input, Direction::BOTTOM)) != 0;
+
+                        if (output < 0)
+                        {
+                            consistent = consistent && !to_bottom && exits_count != 1;
+                        }
+                        else
+                        {
+                            consistent = consistent && output != Direction::TOP && output != input && (turned_connections & link(input, output)) != 0
+                                         && (output == Direction::BOTTOM ? to_bottom : exits_count == 1);
+                        }
+
+                        consistent = consistent && output == paths[rotated_type][0][input];
+                    }
+
+                    for (int other_rotation = 0; other_rotation < 4; other_rotation++)
+                    {
+                        cheaper_twin = cheaper_twin || (haveSamePaths(type, rotation, other_rotation) && (quarters_cost[other_rotation] < quarters_cost[rotation]
+                                                        || (quarters_cost[other_rotation] == quarters_cost[rotation] && other_rotation > rotation)));
+                    }
+
+                    consistent = consistent && distinct_quarters[type][rotation] == !cheaper_twin;
+                    rotated_type = right_of[rotated_type];
+                }
+            }
+
+            return consistent;
+        }
+
+        int connections[TileType::EXIT + 1];            // Type => sides connected in its original orientation, see link().
+        signed char paths[TileType::EXIT + 1][4][4];    // Type, rotation (quarters clockwise), input => output, or -1 if there is no path.
+        bool distinct_quarters[TileType::EXIT + 1][4];  // Type, quarters => FALSE if a cheaper rotation gives the same paths, whatever the tile rotation.
+        unsigned char blocking_quarters[TileType::EXIT + 1][4][4][5]; // Type, rotation, rock entry, player entry + 1 => see blockingRotations().
+
+    private :
+
+        /**
+         * @returns The bits linking two sides of a tile (side * 4 + other side, both ways).
+         */
+        static constexpr int link(int side, int other_side)
+        {
+            return (1 << (side * 4 + other_side)) | (1 << (other_side * 4 + side));
+        }
+};
+
+static constexpr TileOrientations TILE_ORIENTATIONS;
+
+static_assert(TILE_ORIENTATIONS.check(), "Tile orientations are not consistent with the game rotations");
+static_assert(TILE_ORIENTATIONS.paths[TileType::TYPE2][1][Direction::TOP] == Direction::BOTTOM && TILE_ORIENTATIONS.paths[TileType::TYPE2][1][Direction::LEFT] == -1, "TYPE2 turned right is TYPE3");
+static_assert(TILE_ORIENTATIONS.paths[TileType::TYPE6][0][Direction::TOP] == -1 && TILE_ORIENTATIONS.paths[TileType::TYPE6][1][Direction::RIGHT] == Direction::BOTTOM, "TYPE6 is a dead end from the top");
+static_assert(!TILE_ORIENTATIONS.distinct_quarters[TileType::TYPE1][3] && !TILE_ORIENTATIONS.distinct_quarters[TileType::TYPE4][1]
+              && !TILE_ORIENTATIONS.distinct_quarters[TileType::TYPE4][2] && TILE_ORIENTATIONS.distinct_quarters[TileType::TYPE10][2], "Tile symmetries");
+static_assert(TILE_ORIENTATIONS.blockingRotations(TileType::TYPE2, 0, Direction::LEFT, -1) == ((1 << 1) | (1 << 3))
+              && TILE_ORIENTATIONS.blockingRotations(TileType::TYPE4, 0, Direction::RIGHT, Direction::TOP) == 0, "Rock blocking turns");
+
 class Tile;
 
 /**
@@ -112,25 +333,25 @@ class Tile
     public:
         
         // ----------------------------- Constructors -----------------------------
-        Tile() : m_position(), m_type(TileType::TYPE0), m_paths(), m_neighborhood(), m_is_locked(false), m_contains_player(false)
+        Tile() : m_position(), m_type(TileType::TYPE0), m_paths(), m_neighborhood(), m_is_locked(false), m_contains_player(false), m_rotation(0)
         {
             initNeighborhood();
             resetTile();
         }
 
-        explicit Tile(TileType type) : m_position(), m_type(type), m_paths(), m_neighborhood(), m_is_locked(false), m_contains_player(false)
+        explicit Tile(TileType type) : m_position(), m_type(type), m_paths(), m_neighborhood(), m_is_locked(false), m_contains_player(false), m_rotation(0)
         {
             initNeighborhood();
             resetTile();
         }
 
-        Tile(Vector2i position, TileType type) : m_position(position), m_type(type), m_paths(), m_neighborhood(), m_is_locked(false), m_contains_player(false)
+        Tile(Vector2i position, TileType type) : m_position(position), m_type(type), m_paths(), m_neighborhood(), m_is_locked(false), m_contains_player(false), m_rotation(0)
         {
             initNeighborhood();
             resetTile();
         }
 
-        Tile(int x, int y, TileType type) : m_position(x,y), m_type(type), m_paths(), m_neighborhood(), m_is_locked(false), m_contains_player(false)
+        Tile(int x, int y, TileType type) : m_position(x,y), m_type(type), m_paths(), m_neighborhood(), m_is_locked(false), m_contains_player(false), m_rotation(0)
         {
             initNeighborhood();
             resetTile();
@@ -187,87 +408,16 @@ class Tile
         }
         
         /**
-            Tells whether the tile is invariant regarding its paths by 2 quarter rotation (i.e 180 degrees rotation).
+            Tells whether rotating the tile by some quarters gives paths that no cheaper rotation gives (rotations cost 0 for
+            DIRECT, 1 for LEFT or RIGHT, 2 for LEFT LEFT, and LEFT comes before RIGHT).
 
-            @returns TRUE is the tile is invariant by 2 quarters, FALSE otherwise. 
-        **/
-        bool isInvariantBy2Quarters()
-        {
-            switch (m_type)
-            {
-                case TileType::TYPE1 :
-                    return true;
-                case TileType::TYPE2 :
-                    return true;
-                case TileType::TYPE3 :
-                    return true;
-                case TileType::TYPE4 :
-                    return true;
-                case TileType::TYPE5 :
-                    return true;
-                case TileType::TYPE6 :
-                    return false;
-                case TileType::TYPE7 :
-                    return false;
-                case TileType::TYPE8 :
-                    return false;
-                case TileType::TYPE9 :
-                    return false;
-                case TileType::TYPE10 :
-                    return false;
-                case TileType::TYPE11 :
-                    return false;
-                case TileType::TYPE12 :
-                    return false;
-                case TileType::TYPE13 :
-                    return false;
-                case TileType::EXIT :
-                    return true;
-                default: // TYPE0 and other => no path
-                    return true;
-            }
-        }
-        
-        /**
-            Tells whether the tile is invariant regarding its paths whatever we come from the left or the right.
+            @param[in] quarters Quarters clockwise from the current rotation (0 to 3).
 
-            @returns TRUE is the tile is invariant by left to right, FALSE otherwise. 
+            @returns TRUE if the rotation is worth trying, FALSE otherwise.
         **/
-        bool isInvariantByLeftToRight()
+        bool isDistinctRotation(int quarters) const
         {
-            switch (m_type)
-            {
-                case TileType::TYPE1 :
-                    return true;
-                case TileType::TYPE2 :
-                    return true;
-                case TileType::TYPE3 :
-                    return true;
-                case TileType::TYPE4 :
-                    return true;
-                case TileType::TYPE5 :
-                    return true;
-                case TileType::TYPE6 :
-                    return false;
-                case TileType::TYPE7 :
-                    return false;
-                case TileType::TYPE8 :
-                    return false;
-                case TileType::TYPE9 :
-                    return false;
-                case TileType::TYPE10 :
-                    return false;
-                case TileType::TYPE11 :
-                    return false;
-                case TileType::TYPE12 :
-                    return false;
-                case TileType::TYPE13 :
-                    return false;
-                case TileType::EXIT :
-                    return true;
-                default: // TYPE0 and other => no path
-                    return true;
-            }
+            return TILE_ORIENTATIONS.distinct_quarters[m_type][quarters];
         }
         
         /**
@@ -275,66 +425,7 @@ class Tile
         **/
         void resetTile()
         {
-            m_paths.clear();
-            
-            switch (m_type)
-            {
-                case TileType::TYPE1 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE2 :
-                    addPath(Direction::RIGHT, Direction::LEFT);
-                    addPath(Direction::LEFT, Direction::RIGHT);
-                    break;
-                case TileType::TYPE3 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE4 :
-                    addPath(Direction::TOP, Direction::LEFT);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE5 :
-                    addPath(Direction::TOP, Direction::RIGHT);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE6 :
-                    addPath(Direction::LEFT, Direction::RIGHT);
-                    addPath(Direction::RIGHT, Direction::LEFT);
-                    break;
-                case TileType::TYPE7 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE8 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE9 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE10 :
-                    addPath(Direction::TOP, Direction::LEFT);
-                    break;
-                case TileType::TYPE11 :
-                    addPath(Direction::TOP, Direction::RIGHT);
-                    break;
-                case TileType::TYPE12 :
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE13 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::EXIT :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                default: // TYPE0 and other => no path
-                    break;
-            }
+            loadPaths(0);
         }
         
         /**
@@ -343,70 +434,9 @@ class Tile
         **/
         void rotate2Quarters()
         {
-            if (m_is_locked)
+            if (!m_is_locked)
             {
-                return;
-            }
-            
-            m_paths.clear();
-            
-            switch (m_type)
-            {
-                case TileType::TYPE1 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE2 :
-                    addPath(Direction::RIGHT, Direction::LEFT);
-                    addPath(Direction::LEFT, Direction::RIGHT);
-                    break;
-                case TileType::TYPE3 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE4 :
-                    addPath(Direction::TOP, Direction::LEFT);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE5 :
-                    addPath(Direction::TOP, Direction::RIGHT);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE6 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE7 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE8 :
-                    addPath(Direction::LEFT, Direction::RIGHT);
-                    addPath(Direction::RIGHT, Direction::LEFT);
-                    break;
-                case TileType::TYPE9 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE10 :
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE11 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE12 :
-                    addPath(Direction::TOP, Direction::LEFT);
-                    break;
-                case TileType::TYPE13 :
-                    addPath(Direction::TOP, Direction::RIGHT);
-                    break;
-                case TileType::EXIT :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                default: // TYPE0 and other => no path
-                    break;
+                loadPaths(2);
             }
         }
 
@@ -416,144 +446,52 @@ class Tile
         **/
         void rotateAQuarterLeft()
         {
-            if (m_is_locked)
-            {
-                return;
-            }
-
-             m_paths.clear();
-            
-            switch (m_type)
+            if (!m_is_locked)
             {
-                case TileType::TYPE1 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE2 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE3 :
-                    addPath(Direction::LEFT, Direction::RIGHT);
-                    addPath(Direction::RIGHT, Direction::LEFT);
-                    break;
-                case TileType::TYPE4 :
-                    addPath(Direction::TOP, Direction::RIGHT);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE5 :
-                    addPath(Direction::TOP, Direction::LEFT);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE6 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE7 :
-                    addPath(Direction::LEFT, Direction::RIGHT);
-                    addPath(Direction::RIGHT, Direction::LEFT);
-                    break;
-                case TileType::TYPE8 :
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE9 :
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE10 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE11 :
-                    addPath(Direction::TOP, Direction::LEFT);
-                    break;
-                case TileType::TYPE12 :
-                    addPath(Direction::TOP, Direction::RIGHT);
-                    break;                    
-                case TileType::TYPE13 :
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                    
-                case TileType::EXIT :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                default: // TYPE0 and other => no path
-                    break;
+                loadPaths(3);
             }
         }
 
-         /**
+        /**
             Rotates the tile a quarter right (i.e 90 degrees clockwise).
             This updates tile paths in function of the rotation result.
         **/
         void rotateAQuarterRight()
         {
-            if (m_is_locked)
+            if (!m_is_locked)
             {
-                return;
+                loadPaths(1);
             }
+        }
 
-             m_paths.clear();
-            
-            switch (m_type)
+        /**
+            @returns The current rotation of the tile, in quarters clockwise from its original orientation (0 to 3).
+        **/
+        int getRotation() const
+        {
+            return m_rotation;
+        }
+
+        /**
+            Sets the rotation of the tile, as done by the rotation methods.
+
+            @param[in] rotation Rotation in quarters clockwise from the original orientation (0 to 3).
+        **/
+        void setRotation(int rotation)
+        {
+            switch (rotation)
             {
-                case TileType::TYPE1 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE2 :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE3 :
-                    addPath(Direction::LEFT, Direction::RIGHT);
-                    addPath(Direction::RIGHT, Direction::LEFT);
-                    break;
-                case TileType::TYPE4 :
-                    addPath(Direction::TOP, Direction::RIGHT);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
+                case 1 :
+                    rotateAQuarterRight();
                     break;
-                case TileType::TYPE5 :
-                    addPath(Direction::TOP, Direction::LEFT);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
+                case 2 :
+                    rotate2Quarters();
                     break;
-                case TileType::TYPE6 :
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE7 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE8 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE9 :
-                    addPath(Direction::LEFT, Direction::RIGHT);
-                    addPath(Direction::RIGHT, Direction::LEFT);
-                    break;
-                case TileType::TYPE10 :
-                    addPath(Direction::TOP, Direction::RIGHT);
-                    break;
-                case TileType::TYPE11 :
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
-                    break;
-                case TileType::TYPE12 :
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    break;                    
-                case TileType::TYPE13 :
-                    addPath(Direction::TOP, Direction::LEFT);
-                    break;
-                    
-                case TileType::EXIT :
-                    addPath(Direction::TOP, Direction::BOTTOM);
-                    addPath(Direction::LEFT, Direction::BOTTOM);
-                    addPath(Direction::RIGHT, Direction::BOTTOM);
+                case 3 :
+                    rotateAQuarterLeft();
                     break;
-                default: // TYPE0 and other => no path
+                default :
+                    resetTile();
                     break;
             }
         }
@@ -674,17 +612,6 @@ class Tile
         }
 
 
-        /**
-            Adds a path to the current tile for the player.
-
-            @param[in] input Input of the path.
-            @param[in] output Output of the path.
-        **/
-        void addPath(const Direction input, const Direction output)
-        {
-            m_paths[input] = output;
-        }
-
         /**
             @returns Current position of the tile.
         */
@@ -710,7 +637,20 @@ class Tile
         */
         bool hasInputOnDirection(const Direction &direction)
         {
-            return m_paths.find(direction) != m_paths.end();
+            return m_paths[direction] >= 0;
+        }
+
+        /**
+            Tells whether the tile currently leads an input direction to an output direction.
+
+            @param[in] input Input direction.
+            @param[in] output Output direction.
+
+            @returns TRUE if the tile has this path, FALSE otherwise.
+        */
+        bool hasPath(Direction input, Direction output) const
+        {
+            return m_paths[input] == output;
         }
 
         /**
@@ -725,9 +665,9 @@ class Tile
             
             PathNode result(nullptr, input);
                 
-            if (m_paths.find(input) != m_paths.end())
+            if (m_paths[input] >= 0)
             {
-                Direction output_direction = m_paths[input], next_tile_input_direction = getReversedEntryDirection(output_direction);
+                Direction output_direction = (Direction)m_paths[input], next_tile_input_direction = getReversedEntryDirection(output_direction);
 
                 Tile *next_tile = m_neighborhood[output_direction];
                 
@@ -738,19 +678,67 @@ class Tile
             return result;
         }
 
-
-    private:
         /**
-            Inits tile neighbourhood to nullptr.
-        **/
-        void initNeighborhood()
+         * Gives the output informations for an input on the current Tile, as if it had a given rotation. The tile is not rotated.
+         *
+         * @param[in] input The direction from which the character enters the Tile.
+         * @param[in] rotation Rotation in quarters clockwise from the original orientation (0 to 3).
+         *
+         * @returns The next path node (with a nullptr tile if there is no path).
+         */
+        PathNode getRotatedOutput(Direction input, int rotation) const
         {
-            m_neighborhood[Direction::TOP] = nullptr;
-            m_neighborhood[Direction::RIGHT] = nullptr;
-            m_neighborhood[Direction::BOTTOM] = nullptr;
-            m_neighborhood[Direction::LEFT] = nullptr;
+            int output = TILE_ORIENTATIONS.paths[m_type][rotation][input];
+
+            if (output < 0)
+            {
+                return PathNode(nullptr, input);
+            }
+
+            return PathNode(m_neighborhood[output], getReversedEntryDirection((Direction)output));
         }
-       
+
+        /**
+            Tells whether the tile would allow a direction as an input with a given rotation. The tile is not rotated.
+
+            @param[in] direction Direction to test.
+            @param[in] rotation Rotation in quarters clockwise from the original orientation (0 to 3).
+
+            @returns TRUE if the tile would allow the direction as an input, FALSE otherwise.
+        */
+        bool hasRotatedInput(Direction direction, int rotation) const
+        {
+            return TILE_ORIENTATIONS.paths[m_type][rotation][direction] >= 0;
+        }
+
+
+    private:
+        /**
+            Inits tile neighbourhood to nullptr.
+        **/
+        void initNeighborhood()
+        {
+            m_neighborhood[Direction::TOP] = nullptr;
+            m_neighborhood[Direction::RIGHT] = nullptr;
+            m_neighborhood[Direction::BOTTOM] = nullptr;
+            m_neighborhood[Direction::LEFT] = nullptr;
+        }
+
+        /**
+            Sets the rotation of the tile, and its paths under this rotation (see TileOrientations).
+
+            @param[in] rotation Rotation in quarters clockwise from the original orientation (0 to 3).
+        **/
+        void loadPaths(int rotation)
+        {
+            m_rotation = rotation;
+
+            for (int input = 0; input < 4; input++)
+            {
+                m_paths[input] = TILE_ORIENTATIONS.paths[m_type][rotation][input];
+            }
+        }
+       
 
         /**
             Gives the inverse of a direction.
@@ -778,21 +766,45 @@ class Tile
         TileType m_type;
         bool m_is_locked;
         bool m_contains_player;
-        map<Direction,Direction> m_paths; // Keys : input, Values : Output
-        map<Direction, Tile*> m_neighborhood; // tiles around
+        int m_rotation; // Quarters clockwise from the original orientation : 0, 1 (right), 2 or 3 (left).
+        signed char m_paths[4]; // Input => Output, or -1 if there is no path from this input.
+        Tile* m_neighborhood[4]; // tiles around, by direction
 };
 
 
 /**
  * Map storing all the Tiles and their position.
+ *
+ * Tiles are stored row major in storage allocated once for the level (exit line included), so that they never move :
+ * adding a tile only writes it in place, and neighbours are linked in one row major pass once the exit line is added.
  */
 class Map
 {
     public:
         /**
             Map constructor.
+
+            @param[in] width Number of columns.
+            @param[in] height Number of lines of the level, the exit line is added under them.
         **/
-        Map() : m_size(0,0), m_mapping() {}
+        Map(int width, int height) : m_size(width, height + 1), m_tiles(width * (height + 1))
+        {
+            for (int y = 0; y < m_size.y; y++)
+            {
+                for (int x = 0; x < m_size.x; x++)
+                {
+                    m_tiles[y * m_size.x + x].setPosition(x, y);
+                }
+            }
+        }
+
+        Map() = delete;
+
+        /**
+            Tiles point to each other in the storage : a copy would point to the tiles of the original map.
+        **/
+        Map(const Map &map) = delete;
+        Map& operator=(const Map &map) = delete;
 
         /**
             Map destructor. Nothing special because tiles will auto destruct there (they are not pointers).
@@ -810,21 +822,44 @@ class Map
          */
         void addTile(int x, int y, TileType tile_type, bool lockTile = false)
         {
-            Tile newtile(x,y,tile_type);
+            Tile* tile = getTileAt(x, y);
+
+            if (tile == nullptr)
+            {
+                return;
+            }
+
+            *tile = Tile(x, y, tile_type);
 
             if (lockTile)
             {
-                newtile.lock();
+                tile->lock();
             }
+        }
 
-            newtile.setPosition(x,y);
-            Vector2i position(x,y);
+        /**
+         * Adds the exit line under the map : the exit tile, and tiles without paths. The map is complete, its tiles are
+         * linked to their neighbours.
+         *
+         * @param[in] exit_x Position of the exit in the tiles line.
+         */
+        void addExitLine(int exit_x)
+        {
+            int width = m_size.x, exit_line = m_size.y - 1;
 
-            m_mapping[position] = newtile;
-            updateTileNeighborhood(&m_mapping[position]);
+            for (int k = 0; k < width; k++)
+            {
+                if (k == exit_x)
+                {
+                    addTile(k, exit_line, TileType::EXIT); // creates a new tile in the map.
+                }
+                else
+                {
+                    addTile(k, exit_line, TileType::TYPE0); // creates a new tile in the map.
+                }
+            }
 
-            m_size.x = max(m_size.x, x+1);
-            m_size.y = max(m_size.y, y+1);
+            linkTiles();
         }
 
         /**
@@ -838,7 +873,8 @@ class Map
          */
         Vector2i getNextPlayerPosition(int x, int y, Direction input)
         {
-            PathNode nextTileInfos = m_mapping[Vector2i(x,y)].getOutput(input);
+            Tile* tile = getTileAt(x, y);
+            PathNode nextTileInfos = tile != nullptr ? tile->getOutput(input) : PathNode();
 
             if (nextTileInfos.tile != nullptr)
             {
@@ -850,6 +886,14 @@ class Map
             }
         }
 
+        /**
+            @returns The map size, in tiles (exit line included).
+        **/
+        Vector2i getSize() const
+        {
+            return m_size;
+        }
+
         /**
             Accessor to map tiles.
 
@@ -860,715 +904,5245 @@ class Map
         **/
         Tile* getTileAt(int x, int y)
         {
-            Vector2i position(x,y);
-            
-            if (m_mapping.find(position) != m_mapping.end())
-            {
-                return &m_mapping[position];
-            }
-            else
+            if (x < 0 || x >= m_size.x || y < 0 || y >= m_size.y)
             {
                 return nullptr;
             }
+
+            return &m_tiles[y * m_size.x + x];
         }
 
     private :
 
         /**
-         * Updates the neighborhood of a new tile and all the tiles touching it currently, so that the grid remains
-         * consistent in the mapping.
+         * Links every tile to its neighbours, in one row major pass. Tiles on the borders have nullptr neighbours outside.
+         */
+        void linkTiles()
+        {
+            for (int y = 0; y < m_size.y; y++)
+            {
+                for (int x = 0; x < m_size.x; x++)
+                {
+                    m_tiles[y * m_size.x + x].setNeighborhood(getTileAt(x, y-1), getTileAt(x+1, y), getTileAt(x, y+1), getTileAt(x-1, y));
+                }
+            }
+        }
+
+        Vector2i m_size;
+        vector<Tile> m_tiles; // Row major tiles, exit line included.
+};
+
+
+// ============================================================================
+//                              INSTRUMENTATION
+// ============================================================================
+// Define LAST_CRUSADE_INSTRUMENTATION to count what the solvers do and time the game loop phases. One line per turn is
+// written on the error output, e.g :
+//      STATS turn=1 nodes=42 memo_hits=3 dead_states=17 rotations_tried=12 rotations_undone=9 max_depth=21 rock_steps=0 parse_ns=812 path_ns=40250 rocks_ns=310 schedule_ns=1020
+// Without it, the macros below compile to nothing.
+
+#ifdef LAST_CRUSADE_INSTRUMENTATION
+
+/**
+ * Game loop phases timed by the instrumentation.
+ */
+enum GamePhase{INPUT_PARSING = 0, PATH_SOLVING = 1, ROCKS_UPDATE = 2, SCHEDULING = 3};
+
+/**
+ * This class gathers the solver counters and the phases timings of the current turn. Counters are atomic, because
+ * portfolio workers update them too.
+ * It's ok to let the counters public here, they are only incremented and reported.
+ */
+class SolverStatistics
+{
+    public :
+
+        /**
+            Solver statistics constructor. The report is written on the error output as it is at construction (the offline
+            referee mutes std::cerr during games).
+        **/
+        SolverStatistics() : nodes_expanded(0), memo_hits(0), dead_states(0), rotations_tried(0), rotations_undone(0), max_depth(0), rock_steps(0),
+                             m_output(std::cerr.rdbuf()), m_phase_start(std::chrono::steady_clock::now()), m_phase_durations()
+        {}
+
+        /**
+            Solver statistics destructor.
+        **/
+        virtual ~SolverStatistics() = default;
+
+        /**
+         * Records a search depth.
          *
-         * @param[inout] tile The new tile that has just been added to the Map.
+         * @param[in] depth Path length reached by a search.
          */
-        void updateTileNeighborhood(Tile *tile)
+        void updateMaxDepth(int depth)
         {
-            Vector2i tile_position = tile->getPosition(),
-                    top_position(tile_position.x, tile_position.y-1),
-                    right_position(tile_position.x+1, tile_position.y),
-                    bottom_position(tile_position.x, tile_position.y+1),
-                    left_position(tile_position.x-1, tile_position.y)
-            ;
+            int current = max_depth.load(std::memory_order_relaxed);
 
-            auto it_tile_top = m_mapping.find(top_position),
-                    it_tile_right = m_mapping.find(right_position),
-                    it_tile_bottom = m_mapping.find(bottom_position),
-                    it_tile_left = m_mapping.find(left_position); // iterators on the finding of the neighbours
+            while (depth > current && !max_depth.compare_exchange_weak(current, depth, std::memory_order_relaxed));
+        }
 
-            /*
-             *  -|x|-
-             *  -| |-
-             *  -|-|-
-             */
-            if (it_tile_top != m_mapping.end()) // There is a tile above
-            {
-                it_tile_top->second.setTileBottom(tile);
-                tile->setTileTop(&it_tile_top->second);
-            }
+        /**
+         * Starts timing a phase.
+         */
+        void beginPhase()
+        {
+            m_phase_start = std::chrono::steady_clock::now();
+        }
 
-            /*
-             *  -|-|-
-             *  -| |x
-             *  -|-|-
-             */
-            if (it_tile_right != m_mapping.end()) // There is a tile on the right
-            {
-                it_tile_right->second.setTileLeft(tile);
-                tile->setTileRight(&it_tile_right->second);
-            }
+        /**
+         * Adds the time elapsed since the last phase begin or end to a phase, then starts timing the next one.
+         *
+         * @param[in] phase The phase that ends.
+         */
+        void endPhase(GamePhase phase)
+        {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
 
-            /*
-             *  -|-|-
-             *  -| |-
-             *  -|x|-
-             */
-            if (it_tile_bottom != m_mapping.end()) // There is a tile underneath
-            {
-                it_tile_bottom->second.setTileTop(tile);
-                tile->setTileBottom(&it_tile_bottom->second);
-            }
+            m_phase_durations[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_phase_start).count();
+            m_phase_start = now;
+        }
 
-            /*
-             *  -|-|-
-             *  x| |-
-             *  -|-|-
-             */
-            if (it_tile_left != m_mapping.end()) // There is a tile on the left
+        /**
+         * Writes the statistics of the turn, then resets them.
+         *
+         * @param[in] turn Turn number, from 1.
+         */
+        void report(int turn)
+        {
+            m_output << "STATS turn=" << turn << " nodes=" << nodes_expanded << " memo_hits=" << memo_hits << " dead_states=" << dead_states
+                     << " rotations_tried=" << rotations_tried << " rotations_undone=" << rotations_undone << " max_depth=" << max_depth
+                     << " rock_steps=" << rock_steps << " parse_ns=" << m_phase_durations[GamePhase::INPUT_PARSING]
+                     << " path_ns=" << m_phase_durations[GamePhase::PATH_SOLVING] << " rocks_ns=" << m_phase_durations[GamePhase::ROCKS_UPDATE]
+                     << " schedule_ns=" << m_phase_durations[GamePhase::SCHEDULING] << std::endl;
+
+            nodes_expanded = 0;
+            memo_hits = 0;
+            dead_states = 0;
+            rotations_tried = 0;
+            rotations_undone = 0;
+            max_depth = 0;
+            rock_steps = 0;
+
+            for (long long &duration : m_phase_durations)
             {
-                it_tile_left->second.setTileRight(tile);
-                tile->setTileLeft(&it_tile_left->second);
+                duration = 0;
             }
         }
 
-        Vector2i m_size;
-        map<Vector2i, Tile> m_mapping;
+        std::atomic<long long> nodes_expanded;      // Search nodes (DFS calls, labels of the min-rotations search) expanded.
+        std::atomic<long long> memo_hits;           // Labels dropped because a label with as much margin already went on from their state.
+        std::atomic<long long> dead_states;         // Nodes cut because the exit can't be reached from them.
+        std::atomic<long long> rotations_tried;     // Rotations set on the overlay or evaluated by the min-rotations search.
+        std::atomic<long long> rotations_undone;    // Rotations rolled back on the overlay.
+        std::atomic<int> max_depth;                 // Longest path reached by a search.
+        std::atomic<long long> rock_steps;          // Trajectory runs walked to follow the rocks.
+
+    private :
+        std::ostream m_output;
+        std::chrono::steady_clock::time_point m_phase_start;
+        long long m_phase_durations[4];             // Phase => nanoseconds in the turn.
 };
 
+static SolverStatistics SOLVER_STATISTICS;
+
+#define LAST_CRUSADE_COUNT(counter, count) (SOLVER_STATISTICS.counter += (count))
+#define LAST_CRUSADE_DEPTH(depth) SOLVER_STATISTICS.updateMaxDepth(depth)
+#define LAST_CRUSADE_PHASE_BEGIN() SOLVER_STATISTICS.beginPhase()
+#define LAST_CRUSADE_PHASE_END(phase) SOLVER_STATISTICS.endPhase(GamePhase::phase)
+#define LAST_CRUSADE_REPORT(turn) SOLVER_STATISTICS.report(turn)
+
+#else
+
+#define LAST_CRUSADE_COUNT(counter, count)
+#define LAST_CRUSADE_DEPTH(depth)
+#define LAST_CRUSADE_PHASE_BEGIN()
+#define LAST_CRUSADE_PHASE_END(phase)
+#define LAST_CRUSADE_REPORT(turn)
+
+#endif
+
+
+// ============================================================================
+//                              SOLUTION CACHE
+// ============================================================================
+// Define LAST_CRUSADE_SOLUTION_CACHE to keep the player paths solved on the first turn in a memory-mapped file, shared by
+// the runs of a same level layout (e.g. with other rock schedules). The file is LAST_CRUSADE_SOLUTION_CACHE_FILE in the
+// working directory by default, it is created on the first run. A path read from the cache is checked against the map
+// before it is used, and the level is solved as usual if it is missing or invalid.
+
+#ifdef LAST_CRUSADE_SOLUTION_CACHE
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef LAST_CRUSADE_SOLUTION_CACHE_FILE
+#define LAST_CRUSADE_SOLUTION_CACHE_FILE "last_crusade_solutions.cache"
+#endif
+
+#ifndef LAST_CRUSADE_SOLUTION_CACHE_SLOTS
+#define LAST_CRUSADE_SOLUTION_CACHE_SLOTS 1024
+#endif
 
 /**
- * This class describes an instruction to output in the terminal.
- * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ * 128 bits hash of a level : map size, type, rotation and lock of each tile (the exit line gives the exit position), and
+ * the player entry. The two halves are independent 64 bits hashes of the same words.
+ * It's ok to let the fields public here, the key is only computed and compared.
  */
-class SolverInstruction
+class LevelKey
 {
     public :
-        Tile* tile;
-        TileAction action;
-        int path_position;
+        uint64_t low;
+        uint64_t high;
 
-        SolverInstruction() : tile(nullptr), action(TileAction::ROTATE_LEFT){};
-        SolverInstruction(Tile* c_tile, TileAction c_action, int tunnel_position) : tile(c_tile), action(c_action), path_position(tunnel_position) {};
+        LevelKey() : low(0x9E3779B97F4A7C15ULL), high(0xC2B2AE3D27D4EB4FULL) {};
+        ~LevelKey() = default;
+
+        /**
+         * Hashes a level.
+         *
+         * @param[in] map Map of the level, as read on the first turn.
+         * @param[in] start Node the player enters the map by.
+         *
+         * @returns The key of the level.
+         */
+        static LevelKey compute(Map* map, const PathNode &start)
+        {
+            LevelKey key;
+            Vector2i size = map->getSize();
+
+            key.add(((uint64_t)size.x << 32) | (uint32_t)size.y);
+
+            for (int y = 0; y < size.y; y++)
+            {
+                for (int x = 0; x < size.x; x++)
+                {
+                    Tile* tile = map->getTileAt(x, y);
+                    key.add(((uint64_t)tile->getType() << 16) | ((uint64_t)tile->getRotation() << 8) | (tile->isLocked() ? 1 : 0));
+                }
+            }
 
+            Vector2i start_position = start.tile->getPosition();
+            key.add(((uint64_t)start_position.x << 32) | ((uint64_t)start_position.y << 8) | (uint64_t)start.enter_direction);
+
+            return key;
+        }
+
+        bool operator==(const LevelKey &other) const
+        {
+            return low == other.low && high == other.high;
+        }
+
+    private :
+
+        /**
+         * Mixes a word in both halves of the key.
+         *
+         * @param[in] word Word to hash.
+         */
+        void add(uint64_t word)
+        {
+            low = mix((low ^ word) * 0xFF51AFD7ED558CCDULL);
+            high = mix((high + word) * 0xC4CEB9FE1A85EC53ULL + 0x165667B19E3779F9ULL);
+        }
+
+        /**
+         * @returns The 64 bits finalizer of SplitMix64 applied to a value.
+         */
+        static uint64_t mix(uint64_t value)
+        {
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+            return value ^ (value >> 31);
+        }
 };
 
 /**
- * This class performs path finding for the player.
+ * This class stores solved player paths in a memory-mapped file, by level key.
+ *
+ * The file is a header followed by a fixed number of slots, each holding the key of a level and the nodes of its path from
+ * the player entry to the exit (excluded), with the rotation of their tiles. The instructions of a path are the rotations
+ * from the tiles of the map to these rotations (see PathSolver::applyPath()), so they are not stored. Levels are placed by
+ * open addressing on a few slots : when they are all taken, the first one is overwritten. A checksum of the slot is
+ * written last, so a slot torn by a concurrent run reads as a miss.
+ *
+ * When the file can't be opened or mapped, the cache is disabled : nothing is found and nothing is stored.
  */
-class PathSolver
+class SolutionCache
 {
-    public:
+    public :
 
         /**
-            Path solver constructor.
+            Solution cache constructor. The file is opened on the first access.
 
-            @param[in] map The map to solve on.
+            @param[in] path Path of the cache file.
         **/
-        explicit PathSolver(Map* map) : m_map(map) {};
-        PathSolver() = delete;
+        explicit SolutionCache(const char* path) : m_path(path), m_opened(false), m_data(nullptr), m_size(0) {};
+        SolutionCache() = delete;
+        SolutionCache(const SolutionCache&) = delete;
+        SolutionCache& operator=(const SolutionCache&) = delete;
 
         /**
-            Path solver destructor. The map is not destructed by this class. 
+            Solution cache destructor. The file is unmapped, written slots stay in it.
         **/
-        virtual ~PathSolver() = default;
+        virtual ~SolutionCache()
+        {
+            if (m_data != nullptr)
+            {
+                munmap(m_data, m_size);
+            }
+        }
 
         /**
-         * This method resolves player path.
-         * 
-         * @param[in] player_enter_x X coordinate of the first tile the player enters by.
-         * @param[in] player_enter_y Y coordinate of the first tile the player enters by.
-         * @param[in] player_enter_direction Player enter direction on the first tile.
-         * @param[out] instructions SolverInstructions to follow in order to construct the final path through the map.
-         * @param[out] final_path Final player path through the map.
+         * Finds the path of a level.
          *
+         * @param[in] map Map of the level, the nodes are read on its tiles.
+         * @param[in] key Key of the level.
+         * @param[out] path Path nodes from the player entry to the exit (excluded), with the rotations of their tiles.
+         *
+         * @returns TRUE if the level has an intact slot whose nodes are all on the map, FALSE otherwise. The path still has to
+         *          be checked against the tiles.
          */
-        void resolvePathToExit(int player_enter_x, int player_enter_y, Direction player_enter_direction, std::vector<SolverInstruction> &instructions, std::unordered_map<Vector2i,PathNode> &final_path)
+        bool find(Map* map, const LevelKey &key, vector<pair<PathNode, int>> &path)
         {
-            // Making sure we start from scratch.
-            instructions.clear();
-            final_path.clear();
-            
-            // Player start tile
-            Tile* enter_tile = m_map->getTileAt(player_enter_x,player_enter_y);
-            
-            // Path of the player on the first tile
-            PathNode entering(enter_tile, player_enter_direction);
-                       
-            
-            // Processing path finding
-            bool path_exists = computePathToExit(enter_tile, player_enter_direction, instructions, final_path);
-            
-            if (!path_exists)
+            path.clear();
+
+            for (int probe = 0; probe < PROBES_COUNT && open(); probe++)
             {
-                cerr << "##################################################################" << endl;
-                cerr << "############################ NO EXIT #############################" << endl;
-                cerr << "##################################################################" << endl;
+                const CacheSlot* slot = getSlot(key, probe);
+
+                if (slot->key_low != key.low || slot->key_high != key.high)
+                {
+                    continue;
+                }
+
+                if (slot->length == 0 || slot->length > NODES_CAPACITY || slot->checksum != computeChecksum(*slot))
+                {
+                    return false;
+                }
+
+                for (uint32_t k = 0; k < slot->length; k++)
+                {
+                    uint32_t node = slot->nodes[k];
+                    Tile* tile = map->getTileAt(node >> 16, (node >> 4) & 0xFFF);
+
+                    if (tile == nullptr)
+                    {
+                        path.clear();
+                        return false;
+                    }
+
+                    path.push_back(make_pair(PathNode(tile, (Direction)((node >> 2) & 3)), (int)(node & 3)));
+                }
+
+                return true;
             }
-            
+
+            return false;
         }
 
-    private:
-    
         /**
-         * Recursive method that performs path finding for the player to the exit.
-         * 
-         * @param[inout] start_tile The tile the player enters by.
-         * @param[in] entering_direction The direction the palyer enters by on the tile.
-         * @param[inout] instructions_to_follow Instructions retained so far to resolve the current path.
-         * @param[inout] kept_positions Final path positions retained so far.
-         * 
-         * @returns TRUE if a path could be computed from the start_tile to the exit, FALSE otherwise.
-         **/
-        bool computePathToExit(Tile* start_tile, Direction entering_direction, std::vector<SolverInstruction> &instructions_to_follow,  std::unordered_map<Vector2i,PathNode>& kept_positions)
+         * Stores the path of a level. Paths longer than a slot are not stored.
+         *
+         * @param[in] key Key of the level.
+         * @param[in] path Path nodes from the player entry to the exit (excluded), with the rotations of their tiles.
+         */
+        void store(const LevelKey &key, const vector<pair<PathNode, int>> &path)
         {
-            if (kept_positions.find(start_tile->getPosition()) != kept_positions.end())
+            if (path.empty() || path.size() > NODES_CAPACITY || !open())
             {
-                return false;
+                return;
             }
-            
-            PathNode output;
-            
-            if (start_tile->getType() == TileType::EXIT) // Tile is exit
+
+            for (const pair<PathNode, int> &node : path)
+            {
+                if (node.first.tile->getPosition().x > 0xFFFF || node.first.tile->getPosition().y > 0xFFF)
+                {
+                    return;
+                }
+            }
+
+            CacheSlot* slot = getSlot(key, 0);
+
+            for (int probe = 0; probe < PROBES_COUNT; probe++)
+            {
+                CacheSlot* candidate = getSlot(key, probe);
+
+                if (candidate->length == 0 || (candidate->key_low == key.low && candidate->key_high == key.high))
+                {
+                    slot = candidate;
+                    break;
+                }
+            }
+
+            slot->checksum = 0;
+            slot->key_low = key.low;
+            slot->key_high = key.high;
+            slot->length = path.size();
+
+            for (int k = 0; k < (int)path.size(); k++)
+            {
+                Vector2i position = path[k].first.tile->getPosition();
+                slot->nodes[k] = ((uint32_t)position.x << 16) | ((uint32_t)position.y << 4) | ((uint32_t)path[k].first.enter_direction << 2) | (uint32_t)path[k].second;
+            }
+
+            slot->checksum = computeChecksum(*slot);
+        }
+
+    private :
+
+        static constexpr uint64_t MAGIC = 0x3230484341524354ULL;   // "TCRACH02", little endian.
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t NODES_CAPACITY = 1018;           // Nodes of a slot : x (16 bits), y (12 bits), enter direction (2 bits), rotation (2 bits).
+        static constexpr int PROBES_COUNT = 4;                      // Slots a level can be placed on.
+
+        /**
+         * Header of the cache file.
+         */
+        struct CacheHeader
+        {
+            uint64_t magic;
+            uint32_t version;
+            uint32_t slots_count;
+            uint32_t nodes_capacity;
+            uint32_t reserved;
+        };
+
+        /**
+         * Slot of the cache file (4 KiB), empty while its length is 0.
+         */
+        struct CacheSlot
+        {
+            uint64_t key_low;
+            uint64_t key_high;
+            uint32_t length;
+            uint32_t checksum;
+            uint32_t nodes[NODES_CAPACITY];
+        };
+
+        static_assert(sizeof(CacheSlot) == 4096, "Solution cache slot size");
+
+        /**
+         * Opens and maps the cache file on the first call. A file with another header is reset.
+         *
+         * @returns TRUE if the cache is usable, FALSE otherwise.
+         */
+        bool open()
+        {
+            if (m_opened)
+            {
+                return m_data != nullptr;
+            }
+
+            m_opened = true;
+            m_size = sizeof(CacheHeader) + (size_t)LAST_CRUSADE_SOLUTION_CACHE_SLOTS * sizeof(CacheSlot);
+
+            int descriptor = ::open(m_path, O_RDWR | O_CREAT, 0644);
+            struct stat status;
+
+            if (descriptor < 0 || fstat(descriptor, &status) != 0)
+            {
+                cerr << "Solution cache : can't open " << m_path << endl;
+
+                if (descriptor >= 0)
+                {
+                    close(descriptor);
+                }
+
+                return false;
+            }
+
+            bool fresh = (size_t)status.st_size != m_size;
+
+            if (fresh && (ftruncate(descriptor, 0) != 0 || ftruncate(descriptor, m_size) != 0))
+            {
+                cerr << "Solution cache : can't size " << m_path << endl;
+                close(descriptor);
+                return false;
+            }
+
+            void* data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+            close(descriptor);
+
+            if (data == MAP_FAILED)
+            {
+                cerr << "Solution cache : can't map " << m_path << endl;
+                return false;
+            }
+
+            m_data = (unsigned char*)data;
+            CacheHeader* header = (CacheHeader*)m_data;
+
+            if (fresh || header->magic != MAGIC || header->version != VERSION || header->slots_count != LAST_CRUSADE_SOLUTION_CACHE_SLOTS
+                || header->nodes_capacity != NODES_CAPACITY)
+            {
+                memset(m_data, 0, m_size);
+                header->version = VERSION;
+                header->slots_count = LAST_CRUSADE_SOLUTION_CACHE_SLOTS;
+                header->nodes_capacity = NODES_CAPACITY;
+                header->magic = MAGIC;
+            }
+
+            return true;
+        }
+
+        /**
+         * @param[in] key Key of a level.
+         * @param[in] probe Probe number, from 0 to PROBES_COUNT-1.
+         *
+         * @returns The slot a level is looked for on a probe.
+         */
+        CacheSlot* getSlot(const LevelKey &key, int probe) const
+        {
+            size_t index = (key.low + probe) % LAST_CRUSADE_SOLUTION_CACHE_SLOTS;
+            return (CacheSlot*)(m_data + sizeof(CacheHeader) + index * sizeof(CacheSlot));
+        }
+
+        /**
+         * @returns The FNV-1a hash of the key, length and nodes of a slot (never 0, so that a slot being written is torn).
+         */
+        static uint32_t computeChecksum(const CacheSlot &slot)
+        {
+            uint32_t checksum = 2166136261u;
+            uint32_t words[5] = {(uint32_t)slot.key_low, (uint32_t)(slot.key_low >> 32), (uint32_t)slot.key_high, (uint32_t)(slot.key_high >> 32), slot.length};
+
+            for (int k = 0; k < 5 + (int)slot.length; k++)
+            {
+                checksum = (checksum ^ (k < 5 ? words[k] : slot.nodes[k-5])) * 16777619u;
+            }
+
+            return checksum != 0 ? checksum : 1;
+        }
+
+        const char* m_path;
+        bool m_opened;
+        unsigned char* m_data;      // Header, then slots.
+        size_t m_size;
+};
+
+static SolutionCache SOLUTION_CACHE(LAST_CRUSADE_SOLUTION_CACHE_FILE);
+
+#endif
+
+
+/**
+ * Rotations of the map tiles, kept apart from the tiles : searches try rotations on the overlay and the map is left as is.
+ *
+ * Tiles the overlay doesn't rotate keep their own rotation. Every change is recorded on a trail, so mark() and rollback()
+ * undo the changes made since a mark, in O(1) per change. A copy of the overlay (one byte per tile) is an independent branch
+ * of the board, e.g. for another thread. commit() writes the rotations of the overlay to the tiles.
+ */
+class RotationOverlay
+{
+    public :
+        /**
+         * Rotation overlay constructor. The overlay is empty until build() is called.
+         */
+        RotationOverlay() : m_width(0), m_rotations(), m_trail() {}
+
+        /**
+         * Rotation overlay destructor. Tiles are not destructed by this class.
+         */
+        virtual ~RotationOverlay() = default;
+
+        /**
+         * Starts an overlay where every tile has its own rotation, with an empty trail.
+         *
+         * @param[in] map Level map (exit line included).
+         */
+        void build(Map* map)
+        {
+            m_width = map->getSize().x;
+            m_rotations.assign(map->getSize().x * map->getSize().y, -1);
+            m_trail.clear();
+        }
+
+        /**
+         * @param[in] tile A map tile.
+         *
+         * @returns The rotation of the tile in the overlay (0 to 3, see Tile::getRotation()).
+         */
+        int getRotation(Tile* tile) const
+        {
+            int rotation = m_rotations[getIndex(tile)];
+
+            return rotation >= 0 ? rotation : tile->getRotation();
+        }
+
+        /**
+         * Sets the rotation of a tile in the overlay. The change is recorded on the trail.
+         *
+         * @param[in] tile A map tile.
+         * @param[in] rotation Rotation in quarters clockwise from the original orientation (0 to 3).
+         */
+        void setRotation(Tile* tile, int rotation)
+        {
+            int index = getIndex(tile);
+
+            m_trail.push_back(make_pair(tile, m_rotations[index]));
+            m_rotations[index] = rotation;
+
+            LAST_CRUSADE_COUNT(rotations_tried, 1);
+        }
+
+        /**
+         * @returns The current position on the trail, to roll back to.
+         */
+        int mark() const
+        {
+            return m_trail.size();
+        }
+
+        /**
+         * Undoes the changes made since a mark.
+         *
+         * @param[in] trail_mark A position on the trail, given by mark().
+         */
+        void rollback(int trail_mark)
+        {
+            LAST_CRUSADE_COUNT(rotations_undone, max(0, (int)m_trail.size() - trail_mark));
+
+            while ((int)m_trail.size() > trail_mark)
+            {
+                m_rotations[getIndex(m_trail.back().first)] = m_trail.back().second;
+                m_trail.pop_back();
+            }
+        }
+
+        /**
+         * Gives the output informations for an input on a tile, with its rotation in the overlay.
+         *
+         * @param[in] tile A map tile.
+         * @param[in] input The direction from which the character enters the Tile.
+         *
+         * @returns The next path node (with a nullptr tile if there is no path).
+         */
+        PathNode getOutput(Tile* tile, Direction input) const
+        {
+            return tile->getRotatedOutput(input, getRotation(tile));
+        }
+
+        /**
+         * Tells whether a tile allows a direction as an input, with its rotation in the overlay.
+         *
+         * @param[in] tile A map tile.
+         * @param[in] direction Direction to test.
+         *
+         * @returns TRUE if the tile allows the direction as an input, FALSE otherwise.
+         */
+        bool hasInputOnDirection(Tile* tile, Direction direction) const
+        {
+            return tile->hasRotatedInput(direction, getRotation(tile));
+        }
+
+        /**
+         * Rotates the tiles changed on the trail as in the overlay, then clears the trail : tiles have their own rotation again.
+         */
+        void commit()
+        {
+            for (const pair<Tile*, signed char> &change : m_trail)
+            {
+                int index = getIndex(change.first);
+
+                if (m_rotations[index] >= 0)
+                {
+                    change.first->setRotation(m_rotations[index]);
+                    m_rotations[index] = -1;
+                }
+            }
+
+            m_trail.clear();
+        }
+
+    private :
+
+        /**
+         * @param[in] tile A map tile.
+         *
+         * @returns The index of the tile in the overlay : y * map width + x.
+         */
+        int getIndex(Tile* tile) const
+        {
+            return tile->getPosition().y * m_width + tile->getPosition().x;
+        }
+
+        int m_width;                                // Map width, in tiles.
+        vector<signed char> m_rotations;            // Tile index => rotation, or -1 for the rotation of the tile.
+        vector<pair<Tile*, signed char>> m_trail;   // Changes since build() or commit() : tile and previous overlay rotation.
+};
+
+
+/**
+ * Moves an object can make through a tile : entering direction and output direction.
+ */
+enum TileMove{TOP_TO_LEFT = 0, TOP_TO_RIGHT = 1, TOP_TO_BOTTOM = 2, LEFT_TO_RIGHT = 3, LEFT_TO_BOTTOM = 4, RIGHT_TO_LEFT = 5, RIGHT_TO_BOTTOM = 6};
+
+
+/**
+ * Bitboard representation of a Map, with one bit per tile and a row of 64 bits words per map row.
+ *
+ * There is a bitboard per TileMove, telling whether tiles allow the move under some rotation (locked tiles only allow
+ * their current moves), and a bitboard for exit tiles. From them, computeReachability() finds for every tile and entering
+ * direction whether the exit can be reached by rotating the tiles ahead. Objects never go up and never come back in a row,
+ * so they go through a tile at most once and each tile can be rotated for the object : this reachability is exact, and
+ * the states it rejects can be pruned from any path search.
+ *
+ * Rows are processed bottom-up. In a row, moves to the left and to the right are chains, computed with a Kogge-Stone
+ * occluded fill on each word and a carry between words.
+ */
+class MapBitboards
+{
+    public :
+        /**
+         * Map bitboards constructor. Bitboards are empty until build() is called.
+         */
+        MapBitboards() : m_width(0), m_height(0), m_words_per_row(0), m_moves(), m_exits(), m_reach_from_top(), m_reach_from_left(), m_reach_from_right() {}
+
+        /**
+         * Map bitboards destructor.
+         */
+        virtual ~MapBitboards() = default;
+
+        /**
+         * Exports the map tiles as bitboards. Reachability must be computed again afterwards.
+         *
+         * @param[in] map Level map (exit line included).
+         */
+        void build(Map* map)
+        {
+            static const Direction move_inputs[7] = {Direction::TOP, Direction::TOP, Direction::TOP, Direction::LEFT, Direction::LEFT, Direction::RIGHT, Direction::RIGHT};
+            static const Direction move_outputs[7] = {Direction::LEFT, Direction::RIGHT, Direction::BOTTOM, Direction::RIGHT, Direction::BOTTOM, Direction::LEFT, Direction::BOTTOM};
+
+            // Moves allowed by each tile type under some rotation.
+            int rotated_moves[TileType::EXIT+1] = {0};
+
+            for (int type = TileType::TYPE0; type <= TileType::EXIT; type++)
+            {
+                for (int rotation = 0; rotation < 4; rotation++)
+                {
+                    for (int move = 0; move < 7; move++)
+                    {
+                        if (TILE_ORIENTATIONS.paths[type][rotation][move_inputs[move]] == move_outputs[move])
+                        {
+                            rotated_moves[type] |= 1 << move;
+                        }
+                    }
+                }
+            }
+
+            m_width = map->getSize().x;
+            m_height = map->getSize().y;
+            m_words_per_row = (m_width + 63) / 64;
+
+            for (int move = 0; move < 7; move++)
+            {
+                m_moves[move].assign(m_height * m_words_per_row, 0);
+            }
+
+            m_exits.assign(m_height * m_words_per_row, 0);
+
+            for (int y = 0; y < m_height; y++)
+            {
+                for (int x = 0; x < m_width; x++)
+                {
+                    Tile* tile = map->getTileAt(x,y);
+                    int word = y * m_words_per_row + x / 64;
+                    uint64_t bit = uint64_t(1) << (x % 64);
+
+                    if (tile == nullptr)
+                    {
+                        continue;
+                    }
+
+                    if (tile->getType() == TileType::EXIT)
+                    {
+                        m_exits[word] |= bit;
+                    }
+
+                    for (int move = 0; move < 7; move++)
+                    {
+                        bool allowed = tile->isLocked() ? tile->hasPath(move_inputs[move], move_outputs[move]) : (rotated_moves[tile->getType()] >> move) & 1;
+
+                        if (allowed)
+                        {
+                            m_moves[move][word] |= bit;
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * Computes, for every tile and entering direction, whether the exit can be reached.
+         */
+        void computeReachability()
+        {
+            int size = m_height * m_words_per_row;
+
+            m_reach_from_top.assign(size, 0);
+            m_reach_from_left.assign(size, 0);
+            m_reach_from_right.assign(size, 0);
+
+            for (int y = m_height-1; y >= 0; y--)
+            {
+                int row = y * m_words_per_row;
+                int below = row + m_words_per_row;
+                uint64_t carry = 0;
+
+                // Entering by the left : going down, or going right while the tile on the right can be entered by the left.
+                for (int w = m_words_per_row-1; w >= 0; w--)
+                {
+                    uint64_t down = y+1 < m_height ? m_reach_from_top[below + w] : 0;
+                    uint64_t generate = (m_moves[TileMove::LEFT_TO_BOTTOM][row + w] & down) | m_exits[row + w];
+                    uint64_t propagate = m_moves[TileMove::LEFT_TO_RIGHT][row + w];
+
+                    generate |= propagate & (carry << 63);
+                    generate |= propagate & (generate >> 1);
+                    propagate &= propagate >> 1;
+                    generate |= propagate & (generate >> 2);
+                    propagate &= propagate >> 2;
+                    generate |= propagate & (generate >> 4);
+                    propagate &= propagate >> 4;
+                    generate |= propagate & (generate >> 8);
+                    propagate &= propagate >> 8;
+                    generate |= propagate & (generate >> 16);
+                    propagate &= propagate >> 16;
+                    generate |= propagate & (generate >> 32);
+
+                    m_reach_from_left[row + w] = generate;
+                    carry = generate & 1;
+                }
+
+                carry = 0;
+
+                // Entering by the right : going down, or going left while the tile on the left can be entered by the right.
+                for (int w = 0; w < m_words_per_row; w++)
+                {
+                    uint64_t down = y+1 < m_height ? m_reach_from_top[below + w] : 0;
+                    uint64_t generate = (m_moves[TileMove::RIGHT_TO_BOTTOM][row + w] & down) | m_exits[row + w];
+                    uint64_t propagate = m_moves[TileMove::RIGHT_TO_LEFT][row + w];
+
+                    generate |= propagate & carry;
+                    generate |= propagate & (generate << 1);
+                    propagate &= propagate << 1;
+                    generate |= propagate & (generate << 2);
+                    propagate &= propagate << 2;
+                    generate |= propagate & (generate << 4);
+                    propagate &= propagate << 4;
+                    generate |= propagate & (generate << 8);
+                    propagate &= propagate << 8;
+                    generate |= propagate & (generate << 16);
+                    propagate &= propagate << 16;
+                    generate |= propagate & (generate << 32);
+
+                    m_reach_from_right[row + w] = generate;
+                    carry = generate >> 63;
+                }
+
+                // Entering by the top : going down, or going to a side tile entered by that side.
+                for (int w = 0; w < m_words_per_row; w++)
+                {
+                    uint64_t down = y+1 < m_height ? m_reach_from_top[below + w] : 0;
+                    uint64_t left_neighbours = (m_reach_from_right[row + w] << 1) | (w > 0 ? m_reach_from_right[row + w - 1] >> 63 : 0);
+                    uint64_t right_neighbours = (m_reach_from_left[row + w] >> 1) | (w+1 < m_words_per_row ? m_reach_from_left[row + w + 1] << 63 : 0);
+
+                    m_reach_from_top[row + w] = (m_moves[TileMove::TOP_TO_BOTTOM][row + w] & down)
+                                              | (m_moves[TileMove::TOP_TO_LEFT][row + w] & left_neighbours)
+                                              | (m_moves[TileMove::TOP_TO_RIGHT][row + w] & right_neighbours)
+                                              | m_exits[row + w];
+                }
+            }
+        }
+
+        /**
+         * @param[in] x Tile X coordinate.
+         * @param[in] y Tile Y coordinate.
+         * @param[in] move A move through the tile.
+         *
+         * @returns TRUE if the tile allows the move under some rotation, FALSE otherwise.
+         */
+        bool hasMove(int x, int y, TileMove move) const
+        {
+            return testBit(m_moves[move], x, y);
+        }
+
+        /**
+         * @param[in] x Tile X coordinate.
+         * @param[in] y Tile Y coordinate.
+         * @param[in] entering_direction Direction an object enters the tile by.
+         *
+         * @returns TRUE if the exit can be reached from this state by rotating the tiles ahead, FALSE otherwise.
+         */
+        bool canReachExit(int x, int y, Direction entering_direction) const
+        {
+            switch (entering_direction)
+            {
+                case Direction::TOP :
+                    return testBit(m_reach_from_top, x, y);
+                case Direction::LEFT :
+                    return testBit(m_reach_from_left, x, y);
+                case Direction::RIGHT :
+                    return testBit(m_reach_from_right, x, y);
+                default : // Nothing goes up.
+                    return false;
+            }
+        }
+
+    private :
+
+        /**
+         * @param[in] bitboard A bitboard.
+         * @param[in] x Tile X coordinate.
+         * @param[in] y Tile Y coordinate.
+         *
+         * @returns The bit of the tile, FALSE outside the map.
+         */
+        bool testBit(const vector<uint64_t> &bitboard, int x, int y) const
+        {
+            if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+            {
+                return false;
+            }
+
+            return (bitboard[y * m_words_per_row + x / 64] >> (x % 64)) & 1;
+        }
+
+        int m_width;                          // Map width, in tiles.
+        int m_height;                         // Map height, in tiles (exit line included).
+        int m_words_per_row;                  // Number of 64 bits words per row.
+        vector<uint64_t> m_moves[7];          // TileMove => tiles allowing it.
+        vector<uint64_t> m_exits;             // Exit tiles.
+        vector<uint64_t> m_reach_from_top;    // Tiles from which the exit can be reached when entered by the top.
+        vector<uint64_t> m_reach_from_left;   // Tiles from which the exit can be reached when entered by the left.
+        vector<uint64_t> m_reach_from_right;  // Tiles from which the exit can be reached when entered by the right.
+};
+
+
+/**
+ * Tables of the rotation domains (see RotationDomains) : a domain is a set of rotations of a tile, bit r set for the rotation r.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class OrientationSupports
+{
+    public :
+
+        /**
+            Orientation supports constructor : computes the tables from the tile orientations.
+        **/
+        constexpr OrientationSupports() : output_sides(), input_sides(), supported_rotations()
+        {
+            for (int type = TileType::TYPE0; type <= TileType::EXIT; type++)
+            {
+                for (int domain = 0; domain < 16; domain++)
+                {
+                    for (int rotation = 0; rotation < 4; rotation++)
+                    {
+                        for (int input = 0; input < 4 && ((domain >> rotation) & 1) != 0; input++)
+                        {
+                            int output = TILE_ORIENTATIONS.paths[type][rotation][input];
+
+                            output_sides[type][domain] |= output >= 0 ? 1 << output : 0;
+                            input_sides[type][domain] |= output >= 0 ? 1 << input : 0;
+                        }
+                    }
+                }
+
+                for (int fed_sides = 0; fed_sides < 16; fed_sides++)
+                {
+                    for (int lead_sides = 0; lead_sides < 16; lead_sides++)
+                    {
+                        for (int rotation = 0; rotation < 4; rotation++)
+                        {
+                            for (int input = 0; input < 4; input++)
+                            {
+                                int output = TILE_ORIENTATIONS.paths[type][rotation][input];
+                                bool leads = ((fed_sides >> input) & 1) != 0 && output >= 0 && (type == TileType::EXIT || ((lead_sides >> output) & 1) != 0);
+
+                                supported_rotations[type][fed_sides][lead_sides] |= leads ? 1 << rotation : 0;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        unsigned char output_sides[TileType::EXIT + 1][16];                 // Type, domain => sides a path of the domain leads to.
+        unsigned char input_sides[TileType::EXIT + 1][16];                  // Type, domain => sides a path of the domain enters by.
+        unsigned char supported_rotations[TileType::EXIT + 1][16][16];      // Type, fed sides, lead sides => rotations with a path from the first to the second.
+};
+
+static constexpr OrientationSupports ORIENTATION_SUPPORTS;
+
+
+/**
+ * Rotations of the map tiles that can be part of a flow from the player entry to the exit, found by constraint propagation
+ * (AC-3 over the pairs of adjacent tiles). A rotation of a tile is kept while one of its paths is fed, by the player entry
+ * or by a rotation kept on the neighbour it comes from, and leads to a neighbour with a rotation kept that accepts it (the
+ * exit needs no output). When the rotations of a tile shrink, its neighbours are checked again, until nothing changes.
+ *
+ * A path to the exit is never pruned : the rotations it uses always support each other.
+ */
+class RotationDomains
+{
+    public :
+
+        /**
+            Rotation domains constructor. build() must be called before use.
+        **/
+        RotationDomains() : m_map(nullptr), m_width(0), m_domains(), m_queue(), m_queued(), m_start(), m_initial_orientations_count(0)
+        {}
+
+        /**
+            Rotation domains destructor. The map is not destructed by this class.
+        **/
+        virtual ~RotationDomains() = default;
+
+        /**
+         * Computes the domains : every rotation of the unlocked tiles and the current rotation of the locked ones, then
+         * propagated.
+         *
+         * @param[in] map Level map (exit line included), its tiles in their current rotation.
+         * @param[in] start Node the player enters the map by.
+         */
+        void build(Map* map, const PathNode &start)
+        {
+            Vector2i size = map->getSize();
+
+            m_map = map;
+            m_width = size.x;
+            m_start = start;
+            m_domains.assign(size.x * size.y, 0);
+            m_queued.assign(size.x * size.y, false);
+            m_queue.clear();
+
+            for (int y = 0; y < size.y; y++)
+            {
+                for (int x = 0; x < size.x; x++)
+                {
+                    Tile* tile = map->getTileAt(x, y);
+
+                    if (tile->getType() != TileType::TYPE0)
+                    {
+                        m_domains[getIndex(tile)] = tile->isLocked() ? 1 << tile->getRotation() : 15;
+                        enqueue(tile);
+                    }
+                }
+            }
+
+            m_initial_orientations_count = getOrientationsCount();
+            propagate();
+        }
+
+        /**
+         * Removes a tile from the flows (e.g a tile rotated to block a rock, that the model doesn't follow), and propagates
+         * the change to the other tiles.
+         *
+         * @param[in] tile A map tile.
+         */
+        void removeTile(Tile* tile)
+        {
+            m_domains[getIndex(tile)] = 0;
+            enqueueNeighbours(tile);
+            propagate();
+        }
+
+        /**
+         * @param[in] tile A map tile.
+         * @param[in] rotation Rotation in quarters clockwise from the original orientation (0 to 3).
+         *
+         * @returns TRUE if the rotation of the tile can be part of a flow to the exit, FALSE otherwise.
+         */
+        bool allows(Tile* tile, int rotation) const
+        {
+            return (m_domains[getIndex(tile)] >> rotation) & 1;
+        }
+
+        /**
+         * @returns The number of distinct orientations of the unlocked tiles left in the domains (rotations giving the same
+         * paths count once).
+         */
+        int getOrientationsCount() const
+        {
+            int count = 0;
+
+            for (size_t index = 0; index < m_domains.size(); index++)
+            {
+                Tile* tile = m_map->getTileAt(index % m_width, index / m_width);
+
+                for (int rotation = 0; rotation < 4 && !tile->isLocked(); rotation++)
+                {
+                    count += ((m_domains[index] >> rotation) & 1) && tile->isDistinctRotation(rotation) ? 1 : 0;
+                }
+            }
+
+            return count;
+        }
+
+        /**
+         * @returns The number of distinct orientations of the unlocked tiles before the propagation of the last build().
+         */
+        int getInitialOrientationsCount() const
+        {
+            return m_initial_orientations_count;
+        }
+
+    private :
+
+        /**
+         * Removes the unsupported rotations of the queued tiles, queuing the neighbours of the tiles that change.
+         */
+        void propagate()
+        {
+            while (!m_queue.empty())
+            {
+                Tile* tile = m_queue.back();
+                int index = getIndex(tile);
+                int domain = getSupportedRotations(tile);
+
+                m_queue.pop_back();
+                m_queued[index] = false;
+
+                if (domain != m_domains[index])
+                {
+                    m_domains[index] = domain;
+                    enqueueNeighbours(tile);
+                }
+            }
+        }
+
+        /**
+         * @returns The rotations of the tile kept in its domain, with a path fed by a neighbour (or the player entry) that
+         * leads to a neighbour (or out of the exit).
+         */
+        int getSupportedRotations(Tile* tile) const
+        {
+            Vector2i position = tile->getPosition();
+            Tile* neighbours[4] = {m_map->getTileAt(position.x, position.y - 1), m_map->getTileAt(position.x + 1, position.y),
+                                   m_map->getTileAt(position.x, position.y + 1), m_map->getTileAt(position.x - 1, position.y)};
+            int fed_sides = tile == m_start.tile ? 1 << m_start.enter_direction : 0;
+            int lead_sides = 0;
+
+            for (int side = Direction::TOP; side <= Direction::LEFT; side++)
+            {
+                Tile* neighbour = neighbours[side];
+                int facing_side = 1 << ((side + 2) % 4); // Side of the neighbour facing the tile.
+
+                if (neighbour != nullptr)
+                {
+                    int domain = m_domains[getIndex(neighbour)];
+
+                    fed_sides |= (ORIENTATION_SUPPORTS.output_sides[neighbour->getType()][domain] & facing_side) != 0 ? 1 << side : 0;
+                    lead_sides |= (ORIENTATION_SUPPORTS.input_sides[neighbour->getType()][domain] & facing_side) != 0 ? 1 << side : 0;
+                }
+            }
+
+            return m_domains[getIndex(tile)] & ORIENTATION_SUPPORTS.supported_rotations[tile->getType()][fed_sides][lead_sides];
+        }
+
+        /**
+         * Queues a tile to check its rotations.
+         */
+        void enqueue(Tile* tile)
+        {
+            if (tile != nullptr && !m_queued[getIndex(tile)] && m_domains[getIndex(tile)] != 0)
+            {
+                m_queued[getIndex(tile)] = true;
+                m_queue.push_back(tile);
+            }
+        }
+
+        /**
+         * Queues the four neighbours of a tile.
+         */
+        void enqueueNeighbours(Tile* tile)
+        {
+            Vector2i position = tile->getPosition();
+
+            enqueue(m_map->getTileAt(position.x, position.y - 1));
+            enqueue(m_map->getTileAt(position.x + 1, position.y));
+            enqueue(m_map->getTileAt(position.x, position.y + 1));
+            enqueue(m_map->getTileAt(position.x - 1, position.y));
+        }
+
+        /**
+         * @returns The index of a tile in the domains (row major).
+         */
+        int getIndex(Tile* tile) const
+        {
+            return tile->getPosition().y * m_width + tile->getPosition().x;
+        }
+
+        Map* m_map;
+        int m_width;
+        vector<unsigned char> m_domains;      // Tile => bit r set if the rotation r is kept.
+        vector<Tile*> m_queue;                // Tiles to check.
+        vector<bool> m_queued;                // Tile => TRUE if in the queue.
+        PathNode m_start;                     // Player entry.
+        int m_initial_orientations_count;     // Orientations before the propagation (see getInitialOrientationsCount()).
+};
+
+
+/**
+ * This class describes an instruction to output in the terminal.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class SolverInstruction
+{
+    public :
+        Tile* tile;
+        TileAction action;
+        int path_position;
+
+        SolverInstruction() : tile(nullptr), action(TileAction::ROTATE_LEFT){};
+        SolverInstruction(Tile* c_tile, TileAction c_action, int tunnel_position) : tile(c_tile), action(c_action), path_position(tunnel_position) {};
+
+};
+
+/**
+ * This class describes a subproblem of the player path finding : the beginning of the path, with the rotation chosen for
+ * each of its tiles, and the node the search goes on from.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class PathSubproblem
+{
+    public :
+        vector<PathNode> path;  // Beginning of the path, in order.
+        vector<int> rotations;  // Rotation of each tile of the beginning of the path (0 to 3, see Tile::getRotation()).
+        PathNode next;          // Node the search goes on from.
+
+        PathSubproblem() : path(), rotations(), next() {};
+};
+
+
+/**
+ * This class describes a label of the minimum rotations path finding : a node reached, with the margin of the path reaching it.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class PathLabel
+{
+    public :
+        PathNode node;
+        int position;         // Path position of the node.
+        int margin;           // Path position of the node - cost : rotations that can still be done before the player gets there.
+        int parent;           // Label of the previous node (-1 for the start).
+        int parent_rotation;  // Rotation given to the tile of the previous node.
+
+        PathLabel(PathNode c_node, int c_position, int c_margin, int c_parent, int c_parent_rotation) : node(c_node), position(c_position), margin(c_margin), parent(c_parent), parent_rotation(c_parent_rotation) {};
+};
+
+
+/**
+ * This class describes a label of the backward path search : a node from which the exit can be reached, with the rotations
+ * that the path to the exit needs.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class BackwardLabel
+{
+    public :
+        PathNode node;
+        int cost;             // Rotation instructions from the node to the exit.
+        int required_margin;  // Margin the player needs when entering the node for these instructions to be executed in time.
+        int child;            // Label of the next node (-1 for the exit).
+        int rotation;         // Rotation given to the tile of the node.
+
+        BackwardLabel(PathNode c_node, int c_cost, int c_required_margin, int c_child, int c_rotation) : node(c_node), cost(c_cost), required_margin(c_required_margin), child(c_child), rotation(c_rotation) {};
+};
+
+
+/**
+ * Path finding modes.
+ *   - SEQUENTIAL : depth first search on the calling thread.
+ *   - PORTFOLIO : the first levels of the search tree are split into subproblems, solved by a pool of threads on copies of
+ *                 the map. The first path found is kept.
+ *   - DETERMINISTIC_PORTFOLIO : same as PORTFOLIO, but the path kept is the one of the first subproblem with a solution,
+ *                               i.e. the path SEQUENTIAL finds.
+ *   The portfolio modes only pay off with several hardware threads : ./referee solvers measures their speedup.
+ *   - MIN_ROTATIONS : the path needing the fewest rotation instructions that can all be executed in time, found with a
+ *                     shortest path search. Falls back to SEQUENTIAL if it finds nothing.
+ *   - ANYTIME : same as MIN_ROTATIONS, within a time budget. When the budget runs out, the longest safe beginning of a path
+ *               found so far is kept, and extendPath() goes on from its end on the next turns.
+ *   - BIDIRECTIONAL : same path as MIN_ROTATIONS, searched both from the player entry and from the exit until the two
+ *                     searches meet. Falls back to SEQUENTIAL if it finds nothing.
+ */
+enum PathSolverMode{SEQUENTIAL, PORTFOLIO, DETERMINISTIC_PORTFOLIO, MIN_ROTATIONS, ANYTIME, BIDIRECTIONAL};
+
+
+/**
+ * This class performs path finding for the player.
+ */
+class PathSolver
+{
+    public:
+
+        /**
+            Path solver constructor.
+
+            @param[in] map The map to solve on.
+            @param[in] mode Path finding mode.
+            @param[in] threads_count Number of threads of the portfolio modes (0 for one per hardware thread).
+            @param[in] time_budget_ms Time budget of the ANYTIME mode for each call, in milliseconds.
+        **/
+        explicit PathSolver(Map* map, PathSolverMode mode = PathSolverMode::SEQUENTIAL, int threads_count = 0, double time_budget_ms = 0.0) : m_map(map), m_bitboards(), m_domains(), m_overlay(), m_mode(mode),
+                                                                                                                                                  m_threads_count(threads_count), m_cancel_threshold(nullptr), m_rank(0), m_slack(-1), 
+                                                                                                                                                  m_time_budget_ms(time_budget_ms), m_deadline(), m_out_of_time(false), m_deadline_checks(0),
+                                                                                                                                                  m_partial(false), m_frontier(), m_frontier_position(0) {};
+        PathSolver() = delete;
+
+        /**
+            Path solver destructor. The map is not destructed by this class. 
+        **/
+        virtual ~PathSolver() = default;
+
+        /**
+         * This method resolves player path.
+         * 
+         * @param[in] player_enter_x X coordinate of the first tile the player enters by.
+         * @param[in] player_enter_y Y coordinate of the first tile the player enters by.
+         * @param[in] player_enter_direction Player enter direction on the first tile.
+         * @param[out] instructions SolverInstructions to follow in order to construct the final path through the map.
+         * @param[out] final_path Final player path through the map.
+         *
+         */
+        void resolvePathToExit(int player_enter_x, int player_enter_y, Direction player_enter_direction, std::vector<SolverInstruction> &instructions, std::unordered_map<Vector2i,PathNode> &final_path)
+        {
+            // Making sure we start from scratch.
+            instructions.clear();
+            final_path.clear();
+            
+            // Player start tile
+            Tile* enter_tile = m_map->getTileAt(player_enter_x,player_enter_y);
+            
+            // Path of the player on the first tile
+            PathNode entering(enter_tile, player_enter_direction);
+
+#ifdef LAST_CRUSADE_SOLUTION_CACHE
+            // A level already solved by a previous run is not searched again.
+            LevelKey level_key = LevelKey::compute(m_map, entering);
+
+            if (loadCachedPath(level_key, entering, instructions, final_path))
+            {
+                cerr << "Solution cache : path of " << final_path.size() << " tiles loaded" << endl;
+                return;
+            }
+#endif
+
+            // States that can't reach the exit under any rotation are pruned from the search.
+            m_bitboards.build(m_map);
+            m_bitboards.computeReachability();
+
+            // Rotations that can't be part of a flow to the exit are pruned too.
+            m_domains.build(m_map, entering);
+            cerr << "Rotation domains : " << m_domains.getInitialOrientationsCount() << " orientations -> " << m_domains.getOrientationsCount() << endl;
+
+            // Rotations are tried on the overlay, the path found is then committed to the map tiles.
+            m_overlay.build(m_map);
+
+            // Processing path finding
+            bool path_exists = false;
+
+            startClock();
+            m_partial = false;
+
+            if (m_mode == PathSolverMode::MIN_ROTATIONS || m_mode == PathSolverMode::ANYTIME)
+            {
+                path_exists = computeMinimumRotationsPath(entering, 0, 0, instructions, final_path);
+            }
+            else if (m_mode == PathSolverMode::BIDIRECTIONAL)
+            {
+                path_exists = computeBidirectionalPath(entering, instructions, final_path);
+            }
+
+            if (m_mode == PathSolverMode::PORTFOLIO || m_mode == PathSolverMode::DETERMINISTIC_PORTFOLIO)
+            {
+                path_exists = computePathInParallel(entering, instructions, final_path);
+            }
+            else if (!path_exists && !m_partial)
+            {
+                path_exists = computePathToExit(enter_tile, player_enter_direction, instructions, final_path);
+            }
+
+            m_overlay.commit();
+            m_slack = computeSlack(instructions);
+
+#ifdef LAST_CRUSADE_SOLUTION_CACHE
+            if (path_exists && !m_partial && m_slack >= 0)
+            {
+                storeCachedPath(level_key, entering, final_path.size());
+            }
+#endif
+            
+            if (m_partial)
+            {
+                cerr << "Time budget spent : partial player path up to position " << m_frontier_position << endl;
+            }
+            else if (!path_exists)
+            {
+                m_slack = -1;
+
+                cerr << "##################################################################" << endl;
+                cerr << "############################ NO EXIT #############################" << endl;
+                cerr << "##################################################################" << endl;
+            }
+            
+        }
+
+        /**
+         * @returns The slack of the last path found : the number of turns left when its instructions are executed one per turn
+         * from the first turn, at their latest (numeric_limits<int>::max() if no rotation is needed, -1 if no path was found).
+         */
+        int getSlack() const
+        {
+            return m_slack;
+        }
+
+        /**
+         * @returns TRUE if the path found so far stops before the exit (ANYTIME mode), FALSE otherwise.
+         */
+        bool hasPartialPath() const
+        {
+            return m_partial;
+        }
+
+        /**
+         * Removes a tile from the paths searched from now on (e.g rotated to block a rock, out of the model).
+         *
+         * @param[in] tile A map tile.
+         */
+        void excludeTile(Tile* tile)
+        {
+            m_domains.removeTile(tile);
+        }
+
+        /**
+         * Goes on with a partial path, within the time budget : the path is searched from its end, with the rotations that
+         * can still be done in time. The new instructions and positions are appended, and the path found so far is applied to
+         * the map as resolvePathToExit() does.
+         *
+         * The margin of the frontier is kept even if negative, so that no tile the player reaches before the waiting
+         * instructions are done is rotated. When the player is already on the frontier or past it, the path is searched from
+         * the player instead.
+         *
+         * @param[in] turn Current turn (from 1). The player is at path position turn - 1.
+         * @param[in] player Node the player is on.
+         * @param[in] pending_instructions Instructions of the path not executed yet.
+         * @param[inout] instructions Instructions to follow in order to construct the path.
+         * @param[inout] final_path Player path through the map.
+         *
+         * @returns TRUE if the path now reaches the exit, FALSE otherwise.
+         */
+        bool extendPath(int turn, const PathNode &player, int pending_instructions, std::vector<SolverInstruction> &instructions, std::unordered_map<Vector2i,PathNode> &final_path)
+        {
+            if (!m_partial)
+            {
+                return false;
+            }
+
+            startClock();
+            m_partial = false;
+
+            // Rotations left before the player gets to the end of the path : its turns ahead, minus the instructions waiting.
+            if (m_frontier_position <= turn - 1)
+            {
+                m_frontier = player;
+                m_frontier_position = turn - 1;
+            }
+
+            int margin = m_frontier_position - (turn - 1) - pending_instructions;
+            bool path_exists = computeMinimumRotationsPath(m_frontier, m_frontier_position, margin, instructions, final_path);
+
+            m_overlay.commit();
+
+            if (m_partial)
+            {
+                cerr << "Time budget spent : partial player path up to position " << m_frontier_position << endl;
+            }
+            else if (!path_exists)
+            {
+                cerr << "############################ NO EXIT #############################" << endl;
+            }
+
+            return path_exists;
+        }
+
+    private:
+
+        /**
+         * @param[in] instructions Instructions of a path, in path order.
+         *
+         * @returns The slack of the instructions when they are all executed from the first turn, in path order (see
+         * RotationScheduler), or numeric_limits<int>::max() if there are none.
+         */
+        static int computeSlack(const std::vector<SolverInstruction> &instructions)
+        {
+            int slack = numeric_limits<int>::max();
+
+            for (int k = 0; k < (int)instructions.size(); k++)
+            {
+                slack = min(slack, instructions[k].path_position - (k+1));
+            }
+
+            return slack;
+        }
+
+#ifdef LAST_CRUSADE_SOLUTION_CACHE
+        /**
+         * Loads the path of a level from the solution cache. The path must lead from the player entry to the exit through
+         * the tiles of the map, rotate no locked tile, and have instructions that can all be executed in time. It is then
+         * applied and committed to the map as a search would.
+         *
+         * @param[in] key Key of the level.
+         * @param[in] start Node the player enters the map by.
+         * @param[out] instructions Instructions to follow in order to construct the path.
+         * @param[out] final_path Player path through the map.
+         *
+         * @returns TRUE if a valid path was loaded, FALSE otherwise (nothing is changed then).
+         */
+        bool loadCachedPath(const LevelKey &key, const PathNode &start, std::vector<SolverInstruction> &instructions, std::unordered_map<Vector2i,PathNode> &final_path)
+        {
+            vector<pair<PathNode, int>> path;
+
+            if (!SOLUTION_CACHE.find(m_map, key, path) || path[0].first.tile != start.tile || path[0].first.enter_direction != start.enter_direction)
+            {
+                return false;
+            }
+
+            for (int k = 0; k < (int)path.size(); k++)
+            {
+                Tile* tile = path[k].first.tile;
+                int rotation = path[k].second;
+
+                if (tile->isLocked() && rotation != tile->getRotation())
+                {
+                    return false;
+                }
+
+                PathNode output = tile->getRotatedOutput(path[k].first.enter_direction, rotation);
+                bool leads = k+1 < (int)path.size() ? output.tile == path[k+1].first.tile && output.enter_direction == path[k+1].first.enter_direction
+                                                    : output.tile != nullptr && output.tile->getType() == TileType::EXIT;
+
+                if (!leads)
+                {
+                    return false;
+                }
+            }
+
+            std::vector<SolverInstruction> path_instructions;
+            std::unordered_map<Vector2i,PathNode> path_nodes;
+
+            m_overlay.build(m_map);
+            applyPath(path, 0, path_instructions, path_nodes);
+
+            if (computeSlack(path_instructions) < 0)
+            {
+                return false;
+            }
+
+            m_overlay.commit();
+            m_partial = false;
+            m_slack = computeSlack(path_instructions);
+            instructions.swap(path_instructions);
+            final_path.swap(path_nodes);
+
+            return true;
+        }
+
+        /**
+         * Stores the path committed to the map in the solution cache.
+         *
+         * @param[in] key Key of the level.
+         * @param[in] start Node the player enters the map by.
+         * @param[in] length Number of tiles of the path.
+         */
+        void storeCachedPath(const LevelKey &key, const PathNode &start, int length)
+        {
+            vector<pair<PathNode, int>> path;
+            PathNode node = start;
+
+            while (node.tile != nullptr && node.tile->getType() != TileType::EXIT && (int)path.size() < length)
+            {
+                path.push_back(make_pair(node, m_overlay.getRotation(node.tile)));
+                node = m_overlay.getOutput(node.tile, node.enter_direction);
+            }
+
+            if (node.tile != nullptr && node.tile->getType() == TileType::EXIT)
+            {
+                SOLUTION_CACHE.store(key, path);
+            }
+        }
+#endif
+
+        /**
+         * Starts the time budget of a search (ANYTIME mode only).
+         */
+        void startClock()
+        {
+            m_out_of_time = false;
+            m_deadline_checks = 0;
+            m_deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(m_time_budget_ms));
+        }
+
+        /**
+         * Tells whether the time budget is spent. The clock is first read after MINIMUM_SEARCH_NODES calls, so that a search
+         * started late still makes progress, then every 64 calls.
+         *
+         * @returns TRUE if the search must stop, FALSE otherwise (always FALSE out of the ANYTIME mode).
+         */
+        bool isOutOfTime()
+        {
+            if (m_mode == PathSolverMode::ANYTIME && !m_out_of_time && ++m_deadline_checks >= MINIMUM_SEARCH_NODES && (m_deadline_checks & 63) == 0)
+            {
+                m_out_of_time = std::chrono::steady_clock::now() >= m_deadline;
+            }
+
+            return m_out_of_time;
+        }
+    
+        /**
+         * Recursive method that performs path finding for the player to the exit.
+         * 
+         * @param[inout] start_tile The tile the player enters by.
+         * @param[in] entering_direction The direction the palyer enters by on the tile.
+         * @param[inout] instructions_to_follow Instructions retained so far to resolve the current path.
+         * @param[inout] kept_positions Final path positions retained so far.
+         * 
+         * @returns TRUE if a path could be computed from the start_tile to the exit, FALSE otherwise.
+         **/
+        bool computePathToExit(Tile* start_tile, Direction entering_direction, std::vector<SolverInstruction> &instructions_to_follow,  std::unordered_map<Vector2i,PathNode>& kept_positions)
+        {
+            if (kept_positions.find(start_tile->getPosition()) != kept_positions.end())
+            {
+                return false;
+            }
+
+            if (m_cancel_threshold != nullptr && m_cancel_threshold->load(std::memory_order_relaxed) < m_rank) // Portfolio search cancelled
+            {
+                return false;
+            }
+
+            if (isOutOfTime())
+            {
+                return false;
+            }
+
+            if (!isAlive(PathNode(start_tile, entering_direction))) // Only the first tile is not checked by the caller.
+            {
+                return false;
+            }
+
+            LAST_CRUSADE_COUNT(nodes_expanded, 1);
+            LAST_CRUSADE_DEPTH(kept_positions.size());
+            
+            PathNode output;
+            
+            if (start_tile->getType() == TileType::EXIT) // Tile is exit
+            {
+                return true;
+            }
+            else if (start_tile->getType() == TileType::TYPE0) // Tile has no path through it
+            {
+                return false;
+            }
+            else if (start_tile->isLocked()) // Tile can't be moved.
+            {
+                output = m_overlay.getOutput(start_tile, entering_direction);
+                
+                if (!m_domains.allows(start_tile, m_overlay.getRotation(start_tile)) || !isAlive(output))
+                {
+                    return false;
+                }
+                else
+                {
+                    if (output.tile->getType() == TileType::EXIT)
+                    {
+                        return true;
+                    }
+                    else
+                    {
+                        kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));
+                        return computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
+                    }
+                }
+            }
+            else
+            {
+                bool found_exit = false;
+                bool pushed_position = false;
+                int path_position = kept_positions.size();
+                int tile_mark = m_overlay.mark(); // Rotations tried on the tile are undone by rolling back to it.
+               
+               // ============= Try DIRECT ===========
+                output = m_overlay.getOutput(start_tile, entering_direction);
+                
+                if (m_domains.allows(start_tile, m_overlay.getRotation(start_tile)) && isAlive(output))
+                {
+                    //cerr << "---- (" << start_tile->getPosition().x << "," << start_tile->getPosition().y << ") Try DIRECT : ";
+                    kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));
+                    pushed_position = true;
+                    
+                    found_exit = computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
+                    
+                    if (found_exit)
+                    {
+                        return true;
+                    }
+                }
+                
+                
+                // ============= Try LEFT ===========                
+                if (!found_exit && start_tile->isDistinctRotation(3))
+                {
+                    m_overlay.setRotation(start_tile, 3);
+                    
+                    SolverInstruction instruction(start_tile, TileAction::ROTATE_LEFT, path_position);
+                    instructions_to_follow.push_back(instruction);
+                    
+                    
+                    output = m_overlay.getOutput(start_tile, entering_direction);
+                    
+                    if (m_domains.allows(start_tile, m_overlay.getRotation(start_tile)) && isAlive(output))
+                    {                        
+                        if (!pushed_position)
+                        {
+                            kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));    
+                            pushed_position = true;  
+                        }  
+                        
+                        found_exit = computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
+                        
+                        if (found_exit)
+                        {
+                            return true;
+                        }
+                        else
+                        {
+                            m_overlay.rollback(tile_mark);
+                            instructions_to_follow.pop_back();
+                        }
+                    }
+                    else
+                    {
+                        m_overlay.rollback(tile_mark);
+                        instructions_to_follow.pop_back();
+                    }
+                }
+                
+                
+                // ============= Try RIGHT ===========   
+                if (!found_exit && start_tile->isDistinctRotation(1))
+                {
+                    m_overlay.setRotation(start_tile, 1);
+                    
+                    SolverInstruction instruction(start_tile, TileAction::ROTATE_RIGHT, path_position);
+                    instructions_to_follow.push_back(instruction);
+                
+                    output = m_overlay.getOutput(start_tile, entering_direction);
+                    
+                    if (m_domains.allows(start_tile, m_overlay.getRotation(start_tile)) && isAlive(output))
+                    {
+                        if (!pushed_position)
+                        {
+                            kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));    
+                            pushed_position = true;  
+                        }                  
+                                                
+                        found_exit = computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
+                        
+                        if (found_exit)
+                        {
+                            return true;
+                        }
+                        else
+                        {
+                            m_overlay.rollback(tile_mark);
+                            instructions_to_follow.pop_back();
+                        }
+                    }
+                    else
+                    {
+                        m_overlay.rollback(tile_mark);
+                        instructions_to_follow.pop_back();
+                        
+                    }
+                }
+                
+                
+                 // ============= Try LEFT LEFT ===========
+                if (!found_exit && start_tile->isDistinctRotation(2))
+                {
+                    m_overlay.setRotation(start_tile, 2);
+                    
+                    SolverInstruction instruction(start_tile, TileAction::ROTATE_LEFT, path_position);
+                    instructions_to_follow.push_back(instruction);
+                    instructions_to_follow.push_back(instruction);
+                    
+                    output = m_overlay.getOutput(start_tile, entering_direction);
+                    
+                    if (m_domains.allows(start_tile, m_overlay.getRotation(start_tile)) && isAlive(output))
+                    {
+                        if (!pushed_position)
+                        {
+                            kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));    
+                            pushed_position = true;  
+                        }             
+                        
+                        found_exit = computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
+                        
+                        if (found_exit)
+                        {
+                            return true;
+                        }
+                        else
+                        {
+                            m_overlay.rollback(tile_mark);
+                            instructions_to_follow.pop_back();
+                            instructions_to_follow.pop_back();
+                        }
+                    }
+                    else
+                    {
+                        m_overlay.rollback(tile_mark);
+                        instructions_to_follow.pop_back();
+                        instructions_to_follow.pop_back();
+                        
+                    }
+                }
+                
+                
+                if (!found_exit)
+                {
+                    kept_positions.erase(start_tile->getPosition());
+                    
+                    return false;
+                }
+            }
+        }
+    
+        /**
+         * Tells whether a node is worth exploring. Dead states, from which no rotation of the tiles ahead leads to the exit, are
+         * marked by the bitboards reachability pass (backwards from the exit line) before the search.
+         *
+         * @param[in] node The node to explore (its tile can be nullptr).
+         *
+         * @returns TRUE if the exit can be reached from the node, FALSE otherwise.
+         **/
+        bool isAlive(const PathNode &node) const
+        {
+            bool alive = node.tile != nullptr && m_bitboards.canReachExit(node.tile->getPosition().x, node.tile->getPosition().y, node.enter_direction);
+
+            LAST_CRUSADE_COUNT(dead_states, alive ? 0 : 1);
+
+            return alive;
+        }
+
+        /**
+         * Minimum rotations path finding : Dijkstra over the (tile, entering direction) states, where a move through a tile
+         * costs the rotation instructions it needs (a quarter left or right : 1, a half turn : 2). Costs are 0, 1 or 2, so
+         * labels are queued in 3 buckets of cost (0-1-2 BFS). Nothing goes up nor back in a row, so paths never go through a
+         * tile twice.
+         *
+         * Instructions are executed one per turn, before the player enters their tile : the rotations of the tiles up to path
+         * position p can't be more than p. A label keeps its margin (path position - rotations so far), and a tile can only be
+         * rotated within the margin, so the start tile is never rotated. Labels reaching a state with less margin than a
+         * cheaper one already expanded there are dropped. The path found is applied to the overlay.
+         *
+         * In ANYTIME mode, when the time budget runs out, the path to the deepest label (see isDeeper()) is applied instead, and
+         * its last node is kept as the frontier to go on from.
+         *
+         * @param[in] start Node the search starts from : the player entering the map, or the frontier of a partial path.
+         * @param[in] start_position Path position of the start.
+         * @param[in] start_margin Rotations that can be done before the player gets to the start (negative when the
+         *                         instructions waiting already take more turns than the player leaves).
+         * @param[out] instructions Instructions to follow in order to construct the path (appended).
+         * @param[out] final_path Player path through the map (appended).
+         *
+         * @returns TRUE if a path could be found, FALSE otherwise.
+         **/
+        bool computeMinimumRotationsPath(const PathNode &start, int start_position, int start_margin, std::vector<SolverInstruction> &instructions, std::unordered_map<Vector2i,PathNode> &final_path)
+        {
+            if (!isAlive(start))
+            {
+                return false;
+            }
+
+            Vector2i size = m_map->getSize();
+            vector<int> best_margins(size.x * size.y * 4, numeric_limits<int>::min()); // State => best margin of the labels expanded there.
+            vector<PathLabel> labels;                          // Labels created, their parents come first.
+            vector<int> buckets[3];                             // Cost % 3 => labels to process.
+            int exit_label = -1;
+            int deepest_label = 0;                              // Label of the longest safe path, for the ANYTIME mode.
+            int queued_count = 1;
+
+            labels.push_back(PathLabel(start, start_position, start_margin, -1, m_overlay.getRotation(start.tile)));
+            buckets[0].push_back(0);
+
+            for (int cost = 0; queued_count > 0 && exit_label < 0 && !m_out_of_time; cost++)
+            {
+                vector<int> &bucket = buckets[cost % 3];
+
+                // The bucket grows while processed, with the moves costing nothing.
+                for (size_t i = 0; i < bucket.size() && exit_label < 0 && !isOutOfTime(); i++)
+                {
+                    int label = bucket[i];
+                    PathNode node = labels[label].node;
+                    int margin = labels[label].margin;
+                    int state = getState(node);
+
+                    queued_count--;
+
+                    if (margin <= best_margins[state]) // A cheaper label already went on from here with as much margin.
+                    {
+                        LAST_CRUSADE_COUNT(memo_hits, 1);
+                        continue;
+                    }
+
+                    best_margins[state] = margin;
+                    LAST_CRUSADE_COUNT(nodes_expanded, 1);
+
+                    if (isDeeper(labels[label], labels[deepest_label]))
+                    {
+                        deepest_label = label;
+                    }
+
+                    if (node.tile->getType() == TileType::EXIT)
+                    {
+                        exit_label = label;
+                        continue;
+                    }
+
+                    int rotation = m_overlay.getRotation(node.tile);
+
+                    // Same order as computePathToExit() : DIRECT, LEFT, RIGHT, LEFT LEFT.
+                    for (int quarters : {0, 3, 1, 2})
+                    {
+                        int rotation_cost = quarters == 2 ? 2 : (quarters == 0 ? 0 : 1);
+
+                        if (rotation_cost > margin || (quarters != 0 && node.tile->isLocked()) || !node.tile->isDistinctRotation(quarters)
+                            || !m_domains.allows(node.tile, (rotation + quarters) % 4))
+                        {
+                            continue;
+                        }
+
+                        PathNode next = node.tile->getRotatedOutput(node.enter_direction, (rotation + quarters) % 4);
+                        LAST_CRUSADE_COUNT(rotations_tried, quarters != 0 ? 1 : 0);
+
+                        if (isAlive(next) && margin + 1 - rotation_cost > best_margins[getState(next)])
+                        {
+                            labels.push_back(PathLabel(next, labels[label].position + 1, margin + 1 - rotation_cost, label, (rotation + quarters) % 4));
+                            buckets[(cost + rotation_cost) % 3].push_back(labels.size() - 1);
+                            queued_count++;
+                        }
+                    }
+                }
+
+                bucket.clear();
+            }
+
+            if (exit_label < 0 && !m_out_of_time)
+            {
+                return false;
+            }
+
+            // Partial path : the search goes on from its last node on the next call to extendPath().
+            if (exit_label < 0)
+            {
+                exit_label = deepest_label;
+                m_partial = true;
+                m_frontier = labels[deepest_label].node;
+                m_frontier_position = labels[deepest_label].position;
+            }
+
+            // Path from the start to the exit (excluded). Each label holds the rotation its parent tile was given.
+            vector<pair<PathNode, int>> path;
+
+            for (int label = exit_label; labels[label].parent != -1; label = labels[label].parent)
+            {
+                path.push_back(make_pair(labels[labels[label].parent].node, labels[label].parent_rotation));
+            }
+
+            reverse(path.begin(), path.end());
+            applyPath(path, start_position, instructions, final_path);
+
+            return !m_partial;
+        }
+
+        /**
+         * Applies a path to the overlay : its tiles are given their rotation, and the instructions to rotate them are appended.
+         *
+         * @param[in] path Path nodes from the start to the exit (excluded), with the rotations of their tiles.
+         * @param[in] start_position Path position of the first node.
+         * @param[out] instructions Instructions to follow in order to construct the path (appended).
+         * @param[out] final_path Player path through the map (appended).
+         */
+        void applyPath(const vector<pair<PathNode, int>> &path, int start_position, std::vector<SolverInstruction> &instructions, std::unordered_map<Vector2i,PathNode> &final_path)
+        {
+            LAST_CRUSADE_DEPTH(start_position + path.size());
+
+            for (int k = 0; k < (int)path.size(); k++)
+            {
+                const PathNode &node = path[k].first;
+                int path_position = start_position + k;
+                int quarters = (path[k].second - m_overlay.getRotation(node.tile) + 4) % 4;
+
+                if (quarters == 1)
+                {
+                    instructions.push_back(SolverInstruction(node.tile, TileAction::ROTATE_RIGHT, path_position));
+                }
+                else if (quarters != 0) // A quarter left (3), or two (2).
+                {
+                    for (int quarter = quarters; quarter < 4; quarter++)
+                    {
+                        instructions.push_back(SolverInstruction(node.tile, TileAction::ROTATE_LEFT, path_position));
+                    }
+                }
+
+                m_overlay.setRotation(node.tile, path[k].second);
+                final_path.insert(make_pair(node.tile->getPosition(), node));
+            }
+        }
+
+        /**
+         * Bidirectional path finding : the search of computeMinimumRotationsPath() goes forward from the player entry, and a
+         * mirror search goes backward from the exit over the reversed tile connections. Both are 0-1-2 BFS over the (tile,
+         * entering direction) states, a cost level at a time, the side with the fewest labels waiting going on first.
+         *
+         * A backward label keeps the rotation of its tile, its cost to the exit, and the margin the player needs when entering
+         * it (see BackwardLabel). Labels expanded are chained by state, so that each side finds the labels of the other one
+         * in the state it expands : the searches meet where a forward label has the margin a backward label needs. The search
+         * stops when no meeting can be cheaper than the best one found, and the path through it is applied to the overlay.
+         *
+         * @param[in] start Node the player enters the map by.
+         * @param[out] instructions Instructions to follow in order to construct the path.
+         * @param[out] final_path Player path through the map.
+         *
+         * @returns TRUE if a path could be found, FALSE otherwise.
+         **/
+        bool computeBidirectionalPath(const PathNode &start, std::vector<SolverInstruction> &instructions, std::unordered_map<Vector2i,PathNode> &final_path)
+        {
+            if (!isAlive(start))
+            {
+                return false;
+            }
+
+            Vector2i size = m_map->getSize();
+            int states_count = size.x * size.y * 4;
+            vector<PathLabel> forward_labels;
+            vector<BackwardLabel> backward_labels;
+            vector<int> forward_buckets[3], backward_buckets[3];                // Cost % 3 => labels to process, for each side.
+            vector<int> best_margins(states_count, -1);                         // State => best margin of the forward labels expanded there.
+            vector<int> best_required_margins(states_count, numeric_limits<int>::max()); // State => same for the backward labels.
+            vector<int> forward_heads(states_count, -1), backward_heads(states_count, -1); // State => last label expanded there.
+            vector<int> forward_chains, backward_chains;                         // Label => previous label expanded in its state.
+            int forward_cost = 0, backward_cost = 0;
+            int forward_queued = 1, backward_queued = 0;
+            int best_cost = numeric_limits<int>::max(), best_forward = -1, best_backward = -1;
+
+            forward_labels.push_back(PathLabel(start, 0, 0, -1, m_overlay.getRotation(start.tile)));
+            forward_buckets[0].push_back(0);
+
+            for (int x = 0; x < size.x; x++)
+            {
+                Tile* tile = m_map->getTileAt(x, size.y - 1);
+
+                for (int direction = Direction::TOP; direction <= Direction::LEFT && tile->getType() == TileType::EXIT; direction++)
+                {
+                    backward_labels.push_back(BackwardLabel(PathNode(tile, (Direction)direction), 0, 0, -1, m_overlay.getRotation(tile)));
+                    backward_buckets[0].push_back(backward_labels.size() - 1);
+                    backward_queued++;
+                }
+            }
+
+            auto expand_forward = [&](int label)
+            {
+                PathNode node = forward_labels[label].node;
+                int margin = forward_labels[label].margin;
+                int cost = forward_labels[label].position - margin;
+                int state = getState(node);
+
+                if (margin <= best_margins[state])
+                {
+                    LAST_CRUSADE_COUNT(memo_hits, 1);
+                    return;
+                }
+
+                best_margins[state] = margin;
+                forward_chains.resize(forward_labels.size(), -1);
+                forward_chains[label] = forward_heads[state];
+                forward_heads[state] = label;
+                LAST_CRUSADE_COUNT(nodes_expanded, 1);
+
+                for (int other = backward_heads[state]; other != -1; other = backward_chains[other])
+                {
+                    if (backward_labels[other].required_margin <= margin && cost + backward_labels[other].cost < best_cost)
+                    {
+                        best_cost = cost + backward_labels[other].cost;
+                        best_forward = label;
+                        best_backward = other;
+                    }
+                }
+
+                if (node.tile->getType() == TileType::EXIT)
+                {
+                    return;
+                }
+
+                int rotation = m_overlay.getRotation(node.tile);
+
+                for (int quarters : {0, 3, 1, 2})
+                {
+                    int rotation_cost = quarters == 2 ? 2 : (quarters == 0 ? 0 : 1);
+
+                    if (rotation_cost > margin || (quarters != 0 && node.tile->isLocked()) || !node.tile->isDistinctRotation(quarters)
+                        || !m_domains.allows(node.tile, (rotation + quarters) % 4))
+                    {
+                        continue;
+                    }
+
+                    PathNode next = node.tile->getRotatedOutput(node.enter_direction, (rotation + quarters) % 4);
+
+                    if (isAlive(next) && margin + 1 - rotation_cost > best_margins[getState(next)])
+                    {
+                        forward_labels.push_back(PathLabel(next, forward_labels[label].position + 1, margin + 1 - rotation_cost, label, (rotation + quarters) % 4));
+                        forward_buckets[(cost + rotation_cost) % 3].push_back(forward_labels.size() - 1);
+                        forward_queued++;
+                    }
+                }
+            };
+
+            auto expand_backward = [&](int label)
+            {
+                PathNode node = backward_labels[label].node;
+                int required_margin = backward_labels[label].required_margin;
+                int cost = backward_labels[label].cost;
+                int state = getState(node);
+
+                if (required_margin >= best_required_margins[state])
+                {
+                    LAST_CRUSADE_COUNT(memo_hits, 1);
+                    return;
+                }
+
+                best_required_margins[state] = required_margin;
+                backward_chains.resize(backward_labels.size(), -1);
+                backward_chains[label] = backward_heads[state];
+                backward_heads[state] = label;
+                LAST_CRUSADE_COUNT(nodes_expanded, 1);
+
+                for (int other = forward_heads[state]; other != -1; other = forward_chains[other])
+                {
+                    int other_cost = forward_labels[other].position - forward_labels[other].margin;
+
+                    if (forward_labels[other].margin >= required_margin && other_cost + cost < best_cost)
+                    {
+                        best_cost = other_cost + cost;
+                        best_forward = other;
+                        best_backward = label;
+                    }
+                }
+
+                // The previous node is on the tile the node is entered from, and its path leads to the side facing the node.
+                Vector2i position = node.tile->getPosition();
+                Direction side = node.enter_direction;
+                Tile* previous = m_map->getTileAt(position.x + (side == Direction::RIGHT ? 1 : (side == Direction::LEFT ? -1 : 0)), position.y + (side == Direction::BOTTOM ? 1 : (side == Direction::TOP ? -1 : 0)));
+
+                if (previous == nullptr || previous->getType() == TileType::TYPE0)
+                {
+                    return;
+                }
+
+                int rotation = m_overlay.getRotation(previous);
+
+                for (int quarters : {0, 3, 1, 2})
+                {
+                    int rotation_cost = quarters == 2 ? 2 : (quarters == 0 ? 0 : 1);
+                    int previous_rotation = (rotation + quarters) % 4;
+
+                    if ((quarters != 0 && previous->isLocked()) || !previous->isDistinctRotation(quarters) || !m_domains.allows(previous, previous_rotation))
+                    {
+                        continue;
+                    }
+
+                    for (int input = Direction::TOP; input <= Direction::LEFT; input++)
+                    {
+                        PathNode previous_node(previous, (Direction)input);
+                        int previous_required_margin = max(rotation_cost, required_margin + rotation_cost - 1);
+
+                        if (TILE_ORIENTATIONS.paths[previous->getType()][previous_rotation][input] == (side + 2) % 4
+                            && previous_required_margin < best_required_margins[getState(previous_node)])
+                        {
+                            backward_labels.push_back(BackwardLabel(previous_node, cost + rotation_cost, previous_required_margin, label, previous_rotation));
+                            backward_buckets[(cost + rotation_cost) % 3].push_back(backward_labels.size() - 1);
+                            backward_queued++;
+                        }
+                    }
+                }
+            };
+
+            // A meeting is at least as expensive as the cheapest labels left on both sides. When a side has none left, every
+            // label it expanded has been checked against the other side, which only meets it with new labels.
+            while ((forward_queued > 0 || backward_queued > 0)
+                   && (forward_queued > 0 ? forward_cost : 0) + (backward_queued > 0 ? backward_cost : 0) < best_cost)
+            {
+                bool forward = backward_queued == 0 || (forward_queued > 0 && forward_queued <= backward_queued);
+                vector<int> &bucket = forward ? forward_buckets[forward_cost % 3] : backward_buckets[backward_cost % 3];
+
+                // The bucket grows while processed, with the moves costing nothing.
+                for (size_t i = 0; i < bucket.size(); i++)
+                {
+                    if (forward)
+                    {
+                        forward_queued--;
+                        expand_forward(bucket[i]);
+                    }
+                    else
+                    {
+                        backward_queued--;
+                        expand_backward(bucket[i]);
+                    }
+                }
+
+                bucket.clear();
+                (forward ? forward_cost : backward_cost)++;
+            }
+
+            if (best_forward < 0)
+            {
+                return false;
+            }
+
+            // Forward half up to the meeting node (excluded), then backward half from it to the exit (excluded).
+            vector<pair<PathNode, int>> path;
+
+            for (int label = best_forward; forward_labels[label].parent != -1; label = forward_labels[label].parent)
+            {
+                path.push_back(make_pair(forward_labels[forward_labels[label].parent].node, forward_labels[label].parent_rotation));
+            }
+
+            reverse(path.begin(), path.end());
+
+            for (int label = best_backward; backward_labels[label].child != -1; label = backward_labels[label].child)
+            {
+                path.push_back(make_pair(backward_labels[label].node, backward_labels[label].rotation));
+            }
+
+            applyPath(path, 0, instructions, final_path);
+
+            return true;
+        }
+
+        /**
+         * Tells whether a label goes further than another towards the exit : it is on a lower line, or on the same line with
+         * more margin, or as much margin and a shorter path.
+         *
+         * @param[in] label A label.
+         * @param[in] other_label Another label.
+         *
+         * @returns TRUE if the label is deeper than the other one, FALSE otherwise.
+         **/
+        static bool isDeeper(const PathLabel &label, const PathLabel &other_label)
+        {
+            int line = label.node.tile->getPosition().y, other_line = other_label.node.tile->getPosition().y;
+
+            if (line != other_line)
+            {
+                return line > other_line;
+            }
+
+            return label.margin > other_label.margin || (label.margin == other_label.margin && label.position < other_label.position);
+        }
+
+        /**
+         * @param[in] node A path node.
+         *
+         * @returns The state number of the node : (tile index * 4 + entering direction).
+         **/
+        int getState(const PathNode &node) const
+        {
+            return (node.tile->getPosition().y * m_map->getSize().x + node.tile->getPosition().x) * 4 + node.enter_direction;
+        }
+
+        /**
+         * Splits the first levels of the search tree into subproblems, in the order the depth first search explores them.
+         * Locked tiles are followed, and every rotation of an unlocked tile that doesn't lead to a dead state makes a new
+         * subproblem, until there are enough of them or all of them have reached the exit.
+         *
+         * @param[in] start Node the player enters the map by.
+         * @param[in] subproblems_count Number of subproblems wanted.
+         * @param[out] subproblems Subproblems, in search order.
+         **/
+        void splitSearch(const PathNode &start, int subproblems_count, vector<PathSubproblem> &subproblems)
+        {
+            subproblems.clear();
+
+            if (!isAlive(start))
+            {
+                return;
+            }
+
+            PathSubproblem root;
+            root.next = start;
+            subproblems.push_back(root);
+
+            bool split = true;
+
+            while (split && (int)subproblems.size() < subproblems_count)
+            {
+                vector<PathSubproblem> next_subproblems;
+                split = false;
+
+                for (const PathSubproblem &subproblem : subproblems)
+                {
+                    PathNode node = subproblem.next;
+                    PathSubproblem locked_path = subproblem;
+
+                    // Locked tiles leave no choice.
+                    while (node.tile->isLocked() && node.tile->getType() != TileType::EXIT)
+                    {
+                        PathNode output = m_overlay.getOutput(node.tile, node.enter_direction);
+
+                        if (!isAlive(output))
+                        {
+                            break;
+                        }
+
+                        locked_path.path.push_back(node);
+                        locked_path.rotations.push_back(m_overlay.getRotation(node.tile));
+                        node = output;
+                    }
+
+                    locked_path.next = node;
+
+                    if (node.tile->getType() == TileType::EXIT)
+                    {
+                        next_subproblems.push_back(locked_path);
+                        continue;
+                    }
+                    else if (node.tile->isLocked()) // Dead end
+                    {
+                        continue;
+                    }
+
+                    // Same rotations, in the same order, as computePathToExit().
+                    int rotations[4] = {m_overlay.getRotation(node.tile), 3, 1, 2};
+                    bool tried[4] = {true, node.tile->isDistinctRotation(3), node.tile->isDistinctRotation(1), node.tile->isDistinctRotation(2)};
+
+                    for (int i = 0; i < 4; i++)
+                    {
+                        if (!tried[i] || !m_domains.allows(node.tile, rotations[i]))
+                        {
+                            continue;
+                        }
+
+                        PathNode output = node.tile->getRotatedOutput(node.enter_direction, rotations[i]);
+
+                        if (isAlive(output))
+                        {
+                            PathSubproblem child = locked_path;
+                            child.path.push_back(node);
+                            child.rotations.push_back(rotations[i]);
+                            child.next = output;
+                            next_subproblems.push_back(child);
+                            split = true;
+                        }
+                    }
+                }
+
+                subproblems.swap(next_subproblems);
+            }
+        }
+
+        /**
+         * Portfolio path finding : splits the search, then solves the subproblems on a pool of threads. Each thread works on
+         * its own copy of the rotation overlay and takes the next subproblem from a shared counter. A solution cancels the subproblems
+         * ranked after it (DETERMINISTIC_PORTFOLIO) or all the others (PORTFOLIO). The path found is then applied to the map.
+         *
+         * @param[in] start Node the player enters the map by.
+         * @param[out] instructions Instructions to follow in order to construct the path.
+         * @param[out] final_path Player path through the map.
+         *
+         * @returns TRUE if a path could be found, FALSE otherwise.
+         **/
+        bool computePathInParallel(const PathNode &start, std::vector<SolverInstruction> &instructions, std::unordered_map<Vector2i,PathNode> &final_path)
+        {
+            int threads_count = m_threads_count > 0 ? m_threads_count : max(1, (int)std::thread::hardware_concurrency());
+            vector<PathSubproblem> subproblems;
+
+            splitSearch(start, threads_count * 4, subproblems);
+
+            std::atomic<int> next_rank(0);
+            std::atomic<int> cancel_threshold(numeric_limits<int>::max());
+            std::mutex solution_mutex;
+            int solution_rank = numeric_limits<int>::max();
+            vector<pair<PathNode, int>> solution_path;  // Path nodes and rotations of the tiles.
+            vector<SolverInstruction> solution_instructions;
+
+            auto worker = [&]()
+            {
+                PathSolver solver(m_map);
+                solver.m_bitboards = m_bitboards;
+                solver.m_domains = m_domains;
+                solver.m_overlay = m_overlay;
+                solver.m_cancel_threshold = &cancel_threshold;
+
+                for (int rank = next_rank++; rank < (int)subproblems.size() && rank <= cancel_threshold.load(); rank = next_rank++)
+                {
+                    const PathSubproblem &subproblem = subproblems[rank];
+                    vector<SolverInstruction> subproblem_instructions;
+                    unordered_map<Vector2i,PathNode> kept_positions;
+                    int subproblem_mark = solver.m_overlay.mark();
+
+                    for (size_t i = 0; i < subproblem.path.size(); i++)
+                    {
+                        Tile* tile = subproblem.path[i].tile;
+                        int rotation = subproblem.rotations[i];
+
+                        // Same instructions as computePathToExit() : a quarter right (1), a quarter left (3) or two (2).
+                        if (rotation == 1 && rotation != solver.m_overlay.getRotation(tile))
+                        {
+                            subproblem_instructions.push_back(SolverInstruction(tile, TileAction::ROTATE_RIGHT, i));
+                        }
+                        else if (rotation != solver.m_overlay.getRotation(tile))
+                        {
+                            for (int quarter = rotation; quarter < 4; quarter++)
+                            {
+                                subproblem_instructions.push_back(SolverInstruction(tile, TileAction::ROTATE_LEFT, i));
+                            }
+                        }
+
+                        solver.m_overlay.setRotation(tile, rotation);
+                        kept_positions.insert(make_pair(tile->getPosition(), subproblem.path[i]));
+                    }
+
+                    solver.m_rank = rank;
+
+                    if (solver.computePathToExit(subproblem.next.tile, subproblem.next.enter_direction, subproblem_instructions, kept_positions))
+                    {
+                        std::lock_guard<std::mutex> lock(solution_mutex);
+
+                        if (rank < solution_rank)
+                        {
+                            solution_rank = rank;
+                            solution_path.clear();
+                            solution_instructions = subproblem_instructions;
+
+                            for (const pair<const Vector2i, PathNode> &position : kept_positions)
+                            {
+                                solution_path.push_back(make_pair(position.second, solver.m_overlay.getRotation(position.second.tile)));
+                            }
+
+                            cancel_threshold.store(m_mode == PathSolverMode::DETERMINISTIC_PORTFOLIO ? rank : -1);
+                        }
+                    }
+
+                    solver.m_overlay.rollback(subproblem_mark);
+                }
+            };
+
+            vector<std::thread> threads;
+
+            for (int i = 1; i < threads_count; i++)
+            {
+                threads.push_back(std::thread(worker));
+            }
+
+            worker();
+
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+
+            if (solution_rank == numeric_limits<int>::max())
+            {
+                return false;
+            }
+
+            // The solution is applied to the overlay, as the sequential search does.
+            for (const pair<PathNode, int> &position : solution_path)
+            {
+                m_overlay.setRotation(position.first.tile, position.second);
+                final_path.insert(make_pair(position.first.tile->getPosition(), position.first));
+            }
+
+            instructions.insert(instructions.end(), solution_instructions.begin(), solution_instructions.end());
+
+            return true;
+        }
+
+        static constexpr int MINIMUM_SEARCH_NODES = 256;   // Calls to isOutOfTime() before the clock is first read.
+
+        Map* m_map;
+        MapBitboards m_bitboards; // Exit reachability of the map states.
+        RotationDomains m_domains; // Rotations of the tiles that can be part of a flow to the exit.
+        RotationOverlay m_overlay; // Rotations tried by the search.
+        PathSolverMode m_mode;
+        int m_threads_count;                          // Threads of the portfolio modes (0 for one per hardware thread).
+        const std::atomic<int>* m_cancel_threshold;  // Portfolio worker : the search stops when it gets below m_rank.
+        int m_rank;                                   // Portfolio worker : rank of the subproblem being solved.
+        int m_slack;                                  // Slack of the last path found (see getSlack()).
+        double m_time_budget_ms;                      // ANYTIME mode : time budget of each call.
+        std::chrono::steady_clock::time_point m_deadline;
+        bool m_out_of_time;                           // The time budget of the current search is spent.
+        int m_deadline_checks;                        // Calls to isOutOfTime() in the current search.
+        bool m_partial;                               // The path found so far stops before the exit, at the frontier.
+        PathNode m_frontier;                          // Node the partial path stops at (the player will enter it).
+        int m_frontier_position;                      // Path position of the frontier.
+};
+
+/**
+ * Cache of the trajectories of the objects falling through the map (rocks, or the player).
+ *
+ * A state is a tile and the direction an object enters it by, numbered (tile index * 4 + entering direction). The crashed
+ * state is numbered after all the others and leads to itself. For every state, the cache stores :
+ *   - the next state, as given by Tile::getOutput() ;
+ *   - the end of the run of locked tiles that starts after it, i.e. the first state ahead that is crashed, on a stop tile
+ *     or on a tile that can be rotated, with the number of steps to reach it ;
+ *   - binary lifting jump tables : the state 2^j steps ahead, and whether a stop tile is met on the way.
+ *
+ * Trajectories never go up and never come back in a row, so they go through each tile at most once : jump tables with
+ * log2(tiles count) levels cover any trajectory. They are filled by build(), runs are computed lazily. When a tile is rotated,
+ * invalidateTile() only drops the entries of the states upstream of it, and they are computed again when needed. The same
+ * goes for a tile that becomes a stop tile (a longer player path).
+ */
+class TrajectoryCache
+{
+    public :
+        /**
+         * Trajectory cache constructor. The cache is empty until build() is called.
+         */
+        TrajectoryCache() : m_map(nullptr), m_width(0), m_states_count(0), m_levels_count(0), m_tiles(), m_is_stop(), m_next(), m_run_end(), m_run_length(), m_run_valid(), m_jumps(), m_jumps_stop(), m_valid_levels(), m_stamps(), m_stamp(0), m_chain(), m_invalidation_queue() {}
+
+        /**
+         * Trajectory cache destructor. Tiles are owned by the map.
+         */
+        virtual ~TrajectoryCache() = default;
+
+        /**
+         * @returns TRUE if build() has been called, FALSE otherwise.
+         */
+        bool isBuilt() const
+        {
+            return m_map != nullptr;
+        }
+
+        /**
+         * Builds the cache for the current state of the map tiles.
+         *
+         * @param[in] map Level map (exit line included).
+         * @param[in] stop_positions Positions of the stop tiles (typically the player path), where lookups stop.
+         */
+        void build(Map* map, const std::unordered_map<Vector2i,PathNode> &stop_positions)
+        {
+            Vector2i size = map->getSize();
+
+            m_map = map;
+            m_width = size.x;
+            m_states_count = size.x * size.y * 4;
+            m_levels_count = 1;
+
+            while ((1 << (m_levels_count-1)) <= size.x * size.y)
+            {
+                m_levels_count++;
+            }
+
+            m_tiles.assign(size.x * size.y, nullptr);
+            m_is_stop.assign(size.x * size.y, false);
+
+            for (int y = 0; y < size.y; y++)
+            {
+                for (int x = 0; x < size.x; x++)
+                {
+                    m_tiles[y * size.x + x] = map->getTileAt(x,y);
+                    m_is_stop[y * size.x + x] = stop_positions.find(Vector2i(x,y)) != stop_positions.end();
+                }
+            }
+
+            m_next.assign(m_states_count + 1, m_states_count);
+            m_run_end.assign(m_states_count + 1, m_states_count);
+            m_run_length.assign(m_states_count + 1, 0);
+            m_run_valid.assign(m_states_count + 1, false);
+            m_jumps.assign((m_states_count + 1) * m_levels_count, m_states_count);
+            m_jumps_stop.assign((m_states_count + 1) * m_levels_count, false);
+            m_valid_levels.assign(m_states_count + 1, 0);
+            m_stamps.assign(m_states_count + 1, 0);
+
+            for (int state = 0; state < m_states_count; state++)
+            {
+                m_next[state] = computeNext(state);
+            }
+
+            m_run_valid[m_states_count] = true;
+            m_valid_levels[m_states_count] = m_levels_count;
+
+            // Jump tables are filled level by level, each level only needs the previous one.
+            for (int level = 0; level < m_levels_count; level++)
+            {
+                for (int state = 0; state < m_states_count; state++)
+                {
+                    getJump(level, state);
+                }
+            }
+        }
+
+        /**
+         * @param[in] tile A map tile.
+         * @param[in] entering_direction Direction an object enters the tile by.
+         *
+         * @returns The corresponding state.
+         */
+        int getState(Tile* tile, Direction entering_direction) const
+        {
+            Vector2i position = tile->getPosition();
+
+            return (position.y * m_width + position.x) * 4 + entering_direction;
+        }
+
+        /**
+         * @param[in] state A state.
+         *
+         * @returns The corresponding path node, with a nullptr tile for the crashed state.
+         */
+        PathNode getNode(int state) const
+        {
+            if (state == m_states_count)
+            {
+                return PathNode(nullptr, Direction::TOP);
+            }
+
+            return PathNode(m_tiles[state / 4], (Direction)(state % 4));
+        }
+
+        /**
+         * @param[in] state A state.
+         *
+         * @returns The state one step ahead.
+         */
+        int getNext(int state) const
+        {
+            return m_next[state];
+        }
+
+        /**
+         * Gives the end of the run of locked tiles that starts after a state.
+         *
+         * @param[in] state A state.
+         * @param[out] steps Number of steps from the state to the end of the run (at least 1).
+         *
+         * @returns The first state ahead that is crashed, on a stop tile, or on a tile that can be rotated.
+         */
+        int getRunEnd(int state, int &steps)
+        {
+            if (!m_run_valid[state])
+            {
+                computeRun(state);
+            }
+
+            steps = m_run_length[state];
+            return m_run_end[state];
+        }
+
+        /**
+         * Looks for the first stop tile ahead of a state, in O(log n).
+         *
+         * @param[in] state A state.
+         * @param[out] steps Number of steps from the state to the first stop tile, if there is one.
+         *
+         * @returns TRUE if the trajectory meets a stop tile, FALSE if it crashes before.
+         */
+        bool findStopAhead(int state, int &steps)
+        {
+            steps = 0;
+
+            for (int level = m_levels_count-1; level >= 0; level--)
+            {
+                int next_state = getJump(level, state);
+
+                if (!m_jumps_stop[state * m_levels_count + level])
+                {
+                    state = next_state;
+                    steps += 1 << level;
+                }
+            }
+
+            if (isStop(m_next[state]))
+            {
+                steps++;
+                return true;
+            }
+
+            return false;
+        }
+
+        /**
+         * Updates the cache after a tile rotation, or when a tile becomes a stop tile. Only the states upstream of the tile lose
+         * their cached runs and jumps.
+         *
+         * @param[in] tile The changed tile.
+         * @param[in] is_new_stop TRUE if the tile becomes a stop tile (rotated or not), FALSE if it was only rotated.
+         */
+        void invalidateTile(Tile* tile, bool is_new_stop)
+        {
+            invalidateUpstream(tile, is_new_stop && !isStopTile(tile));
+
+            if (is_new_stop)
+            {
+                m_is_stop[getState(tile, Direction::TOP) / 4] = true;
+            }
+        }
+
+        /**
+         * @param[in] tile A map tile.
+         *
+         * @returns TRUE if lookups stop on the tile, FALSE otherwise.
+         */
+        bool isStopTile(Tile* tile) const
+        {
+            return m_is_stop[getState(tile, Direction::TOP) / 4];
+        }
+
+    private :
+
+        /**
+         * Drops the cached runs and jumps that go through a tile, see invalidateTile(). Its own states get their next state
+         * again.
+         *
+         * @param[in] tile The changed tile.
+         * @param[in] stop_changed TRUE if the tile becomes a stop tile (it must not be one yet) : jumps that end on the tile
+         *                         are dropped too, since they report the stop tiles they meet.
+         */
+        void invalidateUpstream(Tile* tile, bool stop_changed)
+        {
+            int first_state = getState(tile, Direction::TOP);
+
+            m_stamp++;
+            m_invalidation_queue.clear();
+
+            // Queue entries : state, distance upstream of the tile, and whether the run of the state goes through the tile.
+            for (int state = first_state; state < first_state + 4; state++)
+            {
+                m_next[state] = computeNext(state);
+                m_stamps[state] = m_stamp;
+                m_invalidation_queue.push_back(make_pair(state, make_pair(0, true)));
+            }
+
+            for (int i = 0; i < (int)m_invalidation_queue.size(); i++)
+            {
+                int state = m_invalidation_queue[i].first;
+                int distance = m_invalidation_queue[i].second.first;
+                bool in_run = m_invalidation_queue[i].second.second;
+                int valid_levels = 0;
+
+                while (valid_levels < m_levels_count && ((1 << valid_levels) < distance || ((1 << valid_levels) == distance && !stop_changed)))
+                {
+                    valid_levels++;
+                }
+
+                m_valid_levels[state] = min(m_valid_levels[state], valid_levels);
+
+                if (in_run)
+                {
+                    m_run_valid[state] = false;
+                }
+
+                if (distance >= (1 << (m_levels_count-1)))
+                {
+                    continue;
+                }
+
+                // Upstream states come from the neighbour on the entering side.
+                Tile* neighbour = getNeighbour(state);
+
+                if (neighbour == nullptr)
+                {
+                    continue;
+                }
+
+                int neighbour_first_state = getState(neighbour, Direction::TOP);
+                bool upstream_in_run = in_run && !isRunEnd(state);
+
+                for (int previous = neighbour_first_state; previous < neighbour_first_state + 4; previous++)
+                {
+                    if (m_next[previous] == state && m_stamps[previous] != m_stamp)
+                    {
+                        m_stamps[previous] = m_stamp;
+                        m_invalidation_queue.push_back(make_pair(previous, make_pair(distance+1, upstream_in_run)));
+                    }
+                }
+            }
+        }
+
+        /**
+         * @param[in] state A state (not the crashed one).
+         *
+         * @returns The state one step ahead, computed from the tile paths.
+         */
+        int computeNext(int state) const
+        {
+            PathNode node = getNode(state);
+            PathNode output = node.tile->getOutput(node.enter_direction);
+
+            if (output.tile == nullptr)
+            {
+                return m_states_count;
+            }
+
+            return getState(output.tile, output.enter_direction);
+        }
+
+        /**
+         * @param[in] state A state (not the crashed one).
+         *
+         * @returns The tile an object comes from when it is in this state, or nullptr on the map borders.
+         */
+        Tile* getNeighbour(int state) const
+        {
+            PathNode node = getNode(state);
+
+            switch (node.enter_direction)
+            {
+                case Direction::TOP :
+                    return node.tile->getTileTop();
+                case Direction::RIGHT :
+                    return node.tile->getTileRight();
+                case Direction::BOTTOM :
+                    return node.tile->getTileBottom();
+                default :
+                    return node.tile->getTileLeft();
+            }
+        }
+
+        /**
+         * @param[in] state A state.
+         *
+         * @returns TRUE if the state is on a stop tile, FALSE otherwise.
+         */
+        bool isStop(int state) const
+        {
+            return state != m_states_count && m_is_stop[state / 4];
+        }
+
+        /**
+         * @param[in] state A state.
+         *
+         * @returns TRUE if a run of locked tiles ends at this state, FALSE if runs go through it.
+         */
+        bool isRunEnd(int state) const
+        {
+            return state == m_states_count || m_is_stop[state / 4] || !m_tiles[state / 4]->isLocked();
+        }
+
+        /**
+         * Computes the run of the given state, and of the states it goes through.
+         *
+         * @param[in] state A state.
+         */
+        void computeRun(int state)
+        {
+            int current = state;
+            int end, length;
+
+            m_chain.clear();
+
+            // Follows the run until its end, or until a state whose run is known.
+            while (true)
+            {
+                m_chain.push_back(current);
+                current = m_next[current];
+
+                if (isRunEnd(current))
+                {
+                    end = current;
+                    length = 0;
+                    break;
+                }
+                else if (m_run_valid[current])
+                {
+                    end = m_run_end[current];
+                    length = m_run_length[current];
+                    break;
+                }
+            }
+
+            for (int i = m_chain.size()-1; i >= 0; i--)
+            {
+                length++;
+                m_run_end[m_chain[i]] = end;
+                m_run_length[m_chain[i]] = length;
+                m_run_valid[m_chain[i]] = true;
+            }
+        }
+
+        /**
+         * Gives a jump table entry, computing the missing levels of the state if needed.
+         *
+         * @param[in] level Jump level : the entry is 2^level steps ahead.
+         * @param[in] state A state.
+         *
+         * @returns The state 2^level steps ahead.
+         */
+        int getJump(int level, int state)
+        {
+            while (m_valid_levels[state] <= level)
+            {
+                int computed_level = m_valid_levels[state];
+
+                int entry = state * m_levels_count + computed_level;
+
+                if (computed_level == 0)
+                {
+                    m_jumps[entry] = m_next[state];
+                    m_jumps_stop[entry] = isStop(m_next[state]);
+                }
+                else
+                {
+                    int middle = getJump(computed_level-1, state);
+                    int end = getJump(computed_level-1, middle);
+
+                    m_jumps[entry] = end;
+                    m_jumps_stop[entry] = m_jumps_stop[entry-1] || m_jumps_stop[middle * m_levels_count + computed_level-1];
+                }
+
+                m_valid_levels[state] = computed_level+1;
+            }
+
+            return m_jumps[state * m_levels_count + level];
+        }
+
+        Map* m_map;                          // Level map.
+        int m_width;                         // Map width, in tiles.
+        int m_states_count;                  // Number of states, which is also the crashed state.
+        int m_levels_count;                  // Number of jump levels.
+        vector<Tile*> m_tiles;               // Tile index => tile.
+        vector<bool> m_is_stop;              // Tile index => TRUE if lookups stop on the tile.
+        vector<int> m_next;                  // State => state one step ahead.
+        vector<int> m_run_end;               // State => end of the run of locked tiles after it.
+        vector<int> m_run_length;            // State => number of steps to the end of its run.
+        vector<bool> m_run_valid;            // State => TRUE if its run is up to date.
+        vector<int> m_jumps;                 // State * levels count + level => state 2^level steps ahead.
+        vector<bool> m_jumps_stop;           // State * levels count + level => TRUE if a stop tile is met in the next 2^level steps.
+        vector<int> m_valid_levels;          // State => number of jump levels up to date for the state.
+        vector<int> m_stamps;                // State => last invalidation that visited it.
+        int m_stamp;                         // Current invalidation.
+        vector<int> m_chain;                 // Buffer for computeRun().
+        vector<pair<int, pair<int,bool>>> m_invalidation_queue; // Buffer for invalidateUpstream().
+};
+
+
+/**
+ * This class describes a way to block a rock : an instruction to repeat on one tile of the rock trajectory, before a deadline.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class RockBlockingOption
+{
+    public :
+        SolverInstruction instruction;
+        int remaining_instructions; // How many times the instruction must still be executed.
+        int deadline; // Turn at which the rock reaches the tile.
+
+        RockBlockingOption() : instruction(), remaining_instructions(0), deadline(0) {};
+        RockBlockingOption(const SolverInstruction &c_instruction, int c_remaining_instructions, int c_deadline) : instruction(c_instruction), remaining_instructions(c_remaining_instructions), deadline(c_deadline) {};
+};
+
+
+/**
+ * Indexed binary min-heap of rock slots, ordered on their deadline.
+ * The index allows to update or remove a rock in O(log n) when the rock table moves it.
+ */
+class RockDeadlineQueue
+{
+    public :
+        /**
+         * Rock deadline queue constructor.
+         */
+        RockDeadlineQueue() : m_heap(), m_positions(), m_deadlines() {}
+
+        /**
+         * Rock deadline queue destructor.
+         */
+        virtual ~RockDeadlineQueue() = default;
+
+        /**
+         * @returns TRUE if no rock is left in the queue, FALSE otherwise.
+         */
+        bool empty() const
+        {
+            return m_heap.empty();
+        }
+
+        /**
+         * @param[in] rock Rock slot to look for.
+         *
+         * @returns TRUE if the rock is in the queue, FALSE otherwise.
+         */
+        bool contains(int rock) const
+        {
+            return rock < (int)m_positions.size() && m_positions[rock] != -1;
+        }
+
+        /**
+         * @returns The slot of the rock with the closest deadline. The queue must not be empty.
+         */
+        int top() const
+        {
+            return m_heap.front();
+        }
+
+        /**
+         * Inserts a rock in the queue, or updates its deadline if it is already in it.
+         *
+         * @param[in] rock Rock slot.
+         * @param[in] deadline New deadline of the rock.
+         */
+        void update(int rock, int deadline)
+        {
+            if (rock >= (int)m_positions.size())
+            {
+                m_positions.resize(rock+1, -1);
+                m_deadlines.resize(rock+1);
+            }
+
+            if (m_positions[rock] == -1)
+            {
+                m_deadlines[rock] = deadline;
+                m_positions[rock] = m_heap.size();
+                m_heap.push_back(rock);
+                siftUp(m_positions[rock]);
+            }
+            else if (deadline < m_deadlines[rock])
+            {
+                m_deadlines[rock] = deadline;
+                siftUp(m_positions[rock]);
+            }
+            else
+            {
+                m_deadlines[rock] = deadline;
+                siftDown(m_positions[rock]);
+            }
+        }
+
+        /**
+         * Removes a rock from the queue (if the rock is in the queue, otherwise it does nothing).
+         *
+         * @param[in] rock Rock slot to remove.
+         */
+        void erase(int rock)
+        {
+            if (!contains(rock))
+            {
+                return;
+            }
+
+            int position = m_positions[rock];
+            int last = m_heap.back();
+
+            m_heap.pop_back();
+            m_positions[rock] = -1;
+
+            if (last != rock)
+            {
+                m_heap[position] = last;
+                m_positions[last] = position;
+                siftUp(position);
+                siftDown(m_positions[last]);
+            }
+        }
+
+    private :
+
+        /**
+         * Moves up the heap entry at the given position until the heap property is restored.
+         *
+         * @param[in] position Position in the heap array.
+         */
+        void siftUp(int position)
+        {
+            while (position > 0)
+            {
+                int parent = (position-1) / 2;
+
+                if (m_deadlines[m_heap[position]] >= m_deadlines[m_heap[parent]])
+                {
+                    break;
+                }
+
+                swapEntries(position, parent);
+                position = parent;
+            }
+        }
+
+        /**
+         * Moves down the heap entry at the given position until the heap property is restored.
+         *
+         * @param[in] position Position in the heap array.
+         */
+        void siftDown(int position)
+        {
+            int size = m_heap.size();
+
+            while (true)
+            {
+                int smallest = position;
+                int left = 2*position + 1;
+                int right = left + 1;
+
+                if (left < size && m_deadlines[m_heap[left]] < m_deadlines[m_heap[smallest]])
+                {
+                    smallest = left;
+                }
+
+                if (right < size && m_deadlines[m_heap[right]] < m_deadlines[m_heap[smallest]])
+                {
+                    smallest = right;
+                }
+
+                if (smallest == position)
+                {
+                    break;
+                }
+
+                swapEntries(position, smallest);
+                position = smallest;
+            }
+        }
+
+        /**
+         * Swaps two heap entries and keeps the positions index up to date.
+         *
+         * @param[in] a First position in the heap array.
+         * @param[in] b Second position in the heap array.
+         */
+        void swapEntries(int a, int b)
+        {
+            swap(m_heap[a], m_heap[b]);
+            m_positions[m_heap[a]] = a;
+            m_positions[m_heap[b]] = b;
+        }
+
+        vector<int> m_heap;       // Rock slots, ordered as a binary heap on their deadline.
+        vector<int> m_positions;  // Rock slot => position in m_heap, or -1 if the rock is not queued.
+        vector<int> m_deadlines;  // Rock slot => current deadline.
+};
+
+
+/**
+ * Dense table of the rocks currently tracked, stored as one array per field so that per turn updates walk contiguous memory.
+ *
+ * Rocks live in slots 0..size()-1. Retiring a rock moves the last one in its slot, so slots are not stable across a retire.
+ * The blocking options of a rock are a slice of a shared pool, and rocks that still need to be blocked are kept in a
+ * RockDeadlineQueue. Once the containers have grown to the level needs, a turn does no allocation.
+ */
+class RockTable
+{
+    public :
+        /**
+         * Rock table constructor.
+         */
+        RockTable() : m_tiles(), m_entries(), m_safety(), m_deadlines(), m_options_begin(), m_options_count(), m_reported_turns(), m_options(), m_spare_options(), m_garbage_options(0), m_deadlines_queue() {}
+
+        /**
+         * Rock table destructor. Tiles are owned by the map.
+         */
+        virtual ~RockTable() = default;
+
+        /**
+         * @returns The number of rocks in the table.
+         */
+        int size() const
+        {
+            return m_tiles.size();
+        }
+
+        /**
+         * Adds a rock to the table, not safe and without blocking options.
+         *
+         * @param[in] node Current rock tile and entering direction.
+         *
+         * @returns The slot of the new rock.
+         */
+        int addRock(const PathNode &node)
+        {
+            m_tiles.push_back(node.tile);
+            m_entries.push_back(node.enter_direction);
+            m_safety.push_back(false);
+            m_deadlines.push_back(numeric_limits<int>::max());
+            m_options_begin.push_back(m_options.size());
+            m_options_count.push_back(0);
+            m_reported_turns.push_back(0);
+
+            return m_tiles.size()-1;
+        }
+
+        /**
+         * Adds a blocking option to a rock. Options of a rock must be added right after it, ordered along its trajectory.
+         * The rock deadline becomes the one of this option, minus the extra turns needed to execute the instruction several times.
+         *
+         * @param[in] rock Slot of the last added rock.
+         * @param[in] instruction Instruction to execute on the blocking tile.
+         * @param[in] instructions_count Number of times the instruction must be executed.
+         * @param[in] deadline Turn at which the rock reaches the blocking tile.
+         */
+        void addBlockingOption(int rock, const SolverInstruction &instruction, int instructions_count, int deadline)
+        {
+            m_options.push_back(RockBlockingOption(instruction, instructions_count, deadline));
+            m_options_count[rock]++;
+            m_deadlines[rock] = deadline - (instructions_count - 1);
+            m_deadlines_queue.update(rock, m_deadlines[rock]);
+        }
+
+        /**
+         * Drops the blocking options of a rock, which is not safe anymore : its options can then be added again, as for a new rock.
+         *
+         * @param[in] rock Rock slot.
+         */
+        void clearOptions(int rock)
+        {
+            m_garbage_options += m_options_count[rock];
+            m_options_begin[rock] = m_options.size();
+            m_options_count[rock] = 0;
+            m_safety[rock] = false;
+            m_deadlines[rock] = numeric_limits<int>::max();
+            m_deadlines_queue.erase(rock);
+        }
+
+        /**
+         * Marks a rock as not able to reach the player path anymore.
+         *
+         * @param[in] rock Rock slot.
+         */
+        void setSafe(int rock)
+        {
+            m_safety[rock] = true;
+            m_deadlines_queue.erase(rock);
+        }
+
+        /**
+         * @param[in] rock Rock slot.
+         *
+         * @returns TRUE if the rock can't reach the player path anymore, FALSE otherwise.
+         */
+        bool isSafe(int rock) const
+        {
+            return m_safety[rock];
+        }
+
+        /**
+         * @param[in] rock Rock slot.
+         *
+         * @returns The tile the rock is currently in.
+         */
+        Tile* getTile(int rock) const
+        {
+            return m_tiles[rock];
+        }
+
+        /**
+         * @param[in] rock Rock slot.
+         *
+         * @returns The direction the rock entered its current tile by.
+         */
+        Direction getEntry(int rock) const
+        {
+            return m_entries[rock];
+        }
+
+        /**
+         * Moves a rock to a new tile.
+         *
+         * @param[in] rock Rock slot.
+         * @param[in] node New rock tile and entering direction.
+         */
+        void moveTo(int rock, const PathNode &node)
+        {
+            m_tiles[rock] = node.tile;
+            m_entries[rock] = node.enter_direction;
+        }
+
+        /**
+         * Records that the game reported a rock during a turn.
+         *
+         * @param[in] rock Rock slot.
+         * @param[in] turn Current turn.
+         */
+        void setReportedTurn(int rock, int turn)
+        {
+            m_reported_turns[rock] = turn;
+        }
+
+        /**
+         * @param[in] rock Rock slot.
+         *
+         * @returns The last turn the game reported the rock.
+         */
+        int getReportedTurn(int rock) const
+        {
+            return m_reported_turns[rock];
+        }
+
+        /**
+         * @param[in] rock Rock slot.
+         *
+         * @returns The number of blocking options of the rock.
+         */
+        int getOptionsCount(int rock) const
+        {
+            return m_options_count[rock];
+        }
+
+        /**
+         * @param[in] rock Rock slot.
+         * @param[in] index Option index, in 0..getOptionsCount(rock)-1, ordered along the rock trajectory.
+         *
+         * @returns The requested blocking option.
+         */
+        RockBlockingOption& getOption(int rock, int index)
+        {
+            return m_options[m_options_begin[rock] + index];
+        }
+
+        /**
+         * @returns TRUE if some rock still has to be blocked, FALSE otherwise.
+         */
+        bool hasRockToBlock() const
+        {
+            return !m_deadlines_queue.empty();
+        }
+
+        /**
+         * @param[in] rock Rock slot.
+         *
+         * @returns TRUE if the rock still has to be blocked, FALSE otherwise.
+         */
+        bool isToBlock(int rock) const
+        {
+            return m_deadlines_queue.contains(rock);
+        }
+
+        /**
+         * @returns The slot of the rock to block with the closest deadline. hasRockToBlock() must be TRUE.
+         */
+        int getMostUrgentRock() const
+        {
+            return m_deadlines_queue.top();
+        }
+
+        /**
+         * Gives up blocking a rock : it stays in the table but is not returned by getMostUrgentRock() anymore.
+         *
+         * @param[in] rock Rock slot.
+         */
+        void giveUpRock(int rock)
+        {
+            m_deadlines_queue.erase(rock);
+        }
+
+        /**
+         * Removes a rock from the table. The last rock is moved to its slot.
+         *
+         * @param[in] rock Rock slot.
+         */
+        void retire(int rock)
+        {
+            int last = m_tiles.size()-1;
+
+            m_garbage_options += m_options_count[rock];
+            m_deadlines_queue.erase(rock);
+
+            if (rock != last)
+            {
+                bool last_queued = m_deadlines_queue.contains(last);
+                m_deadlines_queue.erase(last);
+
+                m_tiles[rock] = m_tiles[last];
+                m_entries[rock] = m_entries[last];
+                m_safety[rock] = m_safety[last];
+                m_deadlines[rock] = m_deadlines[last];
+                m_options_begin[rock] = m_options_begin[last];
+                m_options_count[rock] = m_options_count[last];
+                m_reported_turns[rock] = m_reported_turns[last];
+
+                if (last_queued)
+                {
+                    m_deadlines_queue.update(rock, m_deadlines[rock]);
+                }
+            }
+
+            m_tiles.pop_back();
+            m_entries.pop_back();
+            m_safety.pop_back();
+            m_deadlines.pop_back();
+            m_options_begin.pop_back();
+            m_options_count.pop_back();
+            m_reported_turns.pop_back();
+
+            if (m_garbage_options > 64 && m_garbage_options > (int)m_options.size() - m_garbage_options)
+            {
+                compactOptions();
+            }
+        }
+
+    private :
+
+        /**
+         * Copies the options slices of the live rocks in the spare pool, which then becomes the current one.
+         * Both pools keep their capacity, so this doesn't allocate once they are big enough.
+         */
+        void compactOptions()
+        {
+            m_spare_options.clear();
+
+            for (int rock = 0; rock < (int)m_tiles.size(); rock++)
+            {
+                int begin = m_options_begin[rock];
+
+                m_options_begin[rock] = m_spare_options.size();
+                m_spare_options.insert(m_spare_options.end(), m_options.begin() + begin, m_options.begin() + begin + m_options_count[rock]);
+            }
+
+            swap(m_options, m_spare_options);
+            m_garbage_options = 0;
+        }
+
+        vector<Tile*> m_tiles;                     // Rock slot => current tile.
+        vector<Direction> m_entries;               // Rock slot => direction the rock entered its current tile by.
+        vector<bool> m_safety;                     // Rock slot => TRUE if the rock can't reach the player path anymore.
+        vector<int> m_deadlines;                   // Rock slot => deadline of its last blocking option (the farther tile we can act on).
+        vector<int> m_options_begin;               // Rock slot => index of its first blocking option in m_options.
+        vector<int> m_options_count;               // Rock slot => number of blocking options.
+        vector<int> m_reported_turns;              // Rock slot => last turn the game reported the rock.
+        vector<RockBlockingOption> m_options;      // Blocking options of all the rocks, a slice per rock.
+        vector<RockBlockingOption> m_spare_options;// Pool used to compact m_options.
+        int m_garbage_options;                     // Number of options in m_options that belong to retired rocks.
+        RockDeadlineQueue m_deadlines_queue;       // Rocks that still have to be blocked.
+};
+
+
+/**
+ * Origin of a rotation job.
+ */
+enum RotationJobSource{PLAYER_PATH, ROCK_BLOCKING};
+
+
+/**
+ * This class describes one way to do a rotation job.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class RotationJobAlternative
+{
+    public :
+        int deadline; // Last turn at which the job can be finished.
+        int cost; // Number of turns (i.e. instructions) needed.
+        int payload; // Data for the job owner (the blocking option index for rocks).
+
+        RotationJobAlternative() : deadline(0), cost(0), payload(0) {};
+        RotationJobAlternative(int c_deadline, int c_cost, int c_payload) : deadline(c_deadline), cost(c_cost), payload(c_payload) {};
+};
+
+
+/**
+ * This class describes a rotation job : instructions that must be executed before a deadline, in one of several ways.
+ * It's ok to let the fields public here to simplify access, since the only purpose of this class is to store them.
+ */
+class RotationJob
+{
+    public :
+        RotationJobSource source;
+        int id; // Instruction index for the player path, rock slot for rocks.
+        int first_alternative; // Index of the first alternative in the scheduler alternatives pool.
+        int alternatives_count;
+        int chosen; // Index of the chosen alternative, from 0 to alternatives_count-1.
+
+        RotationJob() : source(RotationJobSource::PLAYER_PATH), id(0), first_alternative(0), alternatives_count(0), chosen(0) {};
+        RotationJob(RotationJobSource c_source, int c_id, int c_first_alternative) : source(c_source), id(c_id), first_alternative(c_first_alternative), alternatives_count(0), chosen(0) {};
+};
+
+
+/**
+ * This class schedules the rotations to output, one per turn, with earliest-deadline-first.
+ *
+ * Jobs are added each turn with their alternatives, the first alternative of a job being the preferred one. With one
+ * instruction per turn, EDF meets every deadline if any order does, so it also tells whether the jobs are feasible at all.
+ * When they are not, jobs with several alternatives are switched to the alternative that frees the most slack.
+ */
+class RotationScheduler
+{
+    public :
+        /**
+         * Rotation scheduler constructor.
+         */
+        RotationScheduler() : m_jobs(), m_alternatives(), m_order(), m_greedy_order(), m_slack(0), m_late_job(-1) {}
+
+        /**
+         * Rotation scheduler destructor.
+         */
+        virtual ~RotationScheduler() = default;
+
+        /**
+         * Removes all the jobs, to schedule a new turn.
+         */
+        void clear()
+        {
+            m_jobs.clear();
+            m_alternatives.clear();
+            m_order.clear();
+            m_slack = 0;
+            m_late_job = -1;
+        }
+
+        /**
+         * Adds a job without alternatives. Alternatives must be added right after, with addAlternative().
+         *
+         * @param[in] source Origin of the job.
+         * @param[in] id Job id for its owner.
+         *
+         * @returns The job index.
+         */
+        int addJob(RotationJobSource source, int id)
+        {
+            m_jobs.push_back(RotationJob(source, id, m_alternatives.size()));
+            return m_jobs.size()-1;
+        }
+
+        /**
+         * Adds an alternative to the last added job.
+         *
+         * @param[in] deadline Last turn at which the job can be finished.
+         * @param[in] cost Number of instructions needed.
+         * @param[in] payload Data for the job owner.
+         */
+        void addAlternative(int deadline, int cost, int payload)
+        {
+            m_alternatives.push_back(RotationJobAlternative(deadline, cost, payload));
+            m_jobs.back().alternatives_count++;
+        }
+
+        /**
+         * Orders the jobs by deadline, checks their feasibility, and chooses alternatives if they are not feasible.
+         *
+         * @param[in] turn Current turn, the first job is executed during it.
+         *
+         * @returns TRUE if every deadline can be met, FALSE otherwise.
+         */
+        bool schedule(int turn)
+        {
+            for (auto &job : m_jobs)
+            {
+                job.chosen = 0;
+            }
+
+            sortJobs();
+
+            if (evaluate(turn))
             {
                 return true;
             }
-            else if (start_tile->getType() == TileType::TYPE0) // Tile has no path through it
+
+            cerr << "Rotations overloaded at turn " << turn << ": " << describeJob(m_late_job) << " misses its deadline by " << -m_slack << " turn(s)" << endl;
+
+            // Greedy pass in deadline order : each job takes the alternative giving the best slack for the whole schedule.
+            // Only the job being tried moves in m_order, so the jobs are visited from a copy of the initial order.
+            m_greedy_order.assign(m_order.begin(), m_order.end());
+
+            for (int job : m_greedy_order)
+            {
+                int best_alternative = m_jobs[job].chosen;
+                int best_slack = m_slack;
+                int best_late_job = m_late_job;
+
+                for (int alternative = 0; alternative < m_jobs[job].alternatives_count; alternative++)
+                {
+                    if (alternative == best_alternative)
+                    {
+                        continue;
+                    }
+
+                    chooseAlternative(job, alternative);
+                    evaluate(turn);
+
+                    if (m_slack > best_slack)
+                    {
+                        best_slack = m_slack;
+                        best_alternative = alternative;
+                        best_late_job = m_late_job;
+                    }
+                }
+
+                chooseAlternative(job, best_alternative);
+                m_slack = best_slack;
+                m_late_job = best_late_job;
+            }
+
+            bool feasible = m_slack >= 0;
+
+            if (!feasible)
+            {
+                cerr << "Rotations still overloaded: " << describeJob(m_late_job) << " misses its deadline by " << -m_slack << " turn(s)" << endl;
+            }
+            else
+            {
+                cerr << "Rotations feasible again with slack " << m_slack << endl;
+            }
+
+            return feasible;
+        }
+
+        /**
+         * @returns The number of jobs.
+         */
+        int getJobsCount() const
+        {
+            return m_order.size();
+        }
+
+        /**
+         * @param[in] rank Rank of the job in the schedule, from 0 to getJobsCount()-1. schedule() must have been called.
+         *
+         * @returns The job executed at this rank : the job of rank 0 is the one to execute this turn if it can be.
+         */
+        const RotationJob& getJob(int rank) const
+        {
+            return m_jobs[m_order[rank]];
+        }
+
+        /**
+         * @param[in] job A job.
+         *
+         * @returns The chosen alternative of the job.
+         */
+        const RotationJobAlternative& getChosenAlternative(const RotationJob &job) const
+        {
+            return m_alternatives[job.first_alternative + job.chosen];
+        }
+
+        /**
+         * @returns The slack of the schedule : the smallest number of turns by which a job finishes before its deadline
+         * (negative if a deadline is missed).
+         */
+        int getSlack() const
+        {
+            return m_slack;
+        }
+
+    private :
+
+        /**
+         * @param[in] a A job index.
+         * @param[in] b Another job index.
+         *
+         * @returns TRUE if job a is executed before job b : earlier deadline first, then insertion order.
+         */
+        bool isBefore(int a, int b) const
+        {
+            int deadline_a = getChosenAlternative(m_jobs[a]).deadline;
+            int deadline_b = getChosenAlternative(m_jobs[b]).deadline;
+
+            return deadline_a < deadline_b || (deadline_a == deadline_b && a < b);
+        }
+
+        /**
+         * Orders the jobs by deadline of their chosen alternative.
+         */
+        void sortJobs()
+        {
+            m_order.resize(m_jobs.size());
+
+            for (int job = 0; job < (int)m_jobs.size(); job++)
+            {
+                m_order[job] = job;
+            }
+
+            sort(m_order.begin(), m_order.end(), [this](int a, int b) { return isBefore(a, b); });
+        }
+
+        /**
+         * Switches a job to another alternative and moves it to its new rank, the other jobs keep their order.
+         *
+         * @param[in] job A job index.
+         * @param[in] alternative Index of the alternative to choose, from 0 to alternatives_count-1.
+         */
+        void chooseAlternative(int job, int alternative)
+        {
+            auto comparator = [this](int a, int b) { return isBefore(a, b); };
+            auto rank = lower_bound(m_order.begin(), m_order.end(), job, comparator);
+
+            m_jobs[job].chosen = alternative;
+
+            if (rank + 1 != m_order.end() && isBefore(*(rank + 1), job))
+            {
+                auto new_rank = lower_bound(rank + 1, m_order.end(), job, comparator);
+                rotate(rank, rank + 1, new_rank);
+            }
+            else if (rank != m_order.begin() && isBefore(job, *(rank - 1)))
+            {
+                auto new_rank = lower_bound(m_order.begin(), rank, job, comparator);
+                rotate(new_rank, rank, rank + 1);
+            }
+        }
+
+        /**
+         * Computes the slack of the schedule, the jobs being executed in the order of m_order.
+         *
+         * @param[in] turn Current turn.
+         *
+         * @returns TRUE if every deadline is met, FALSE otherwise.
+         */
+        bool evaluate(int turn)
+        {
+            int finish_turn = turn - 1;
+
+            m_slack = numeric_limits<int>::max();
+            m_late_job = -1;
+
+            for (int job : m_order)
+            {
+                const RotationJobAlternative &alternative = getChosenAlternative(m_jobs[job]);
+
+                finish_turn += alternative.cost;
+
+                if (alternative.deadline - finish_turn < m_slack)
+                {
+                    m_slack = alternative.deadline - finish_turn;
+                    m_late_job = job;
+                }
+            }
+
+            return m_slack >= 0;
+        }
+
+        /**
+         * @param[in] job A job index.
+         *
+         * @returns A short description of the job, for logs.
+         */
+        string describeJob(int job) const
+        {
+            ostringstream description;
+
+            description << (m_jobs[job].source == RotationJobSource::PLAYER_PATH ? "player path instruction " : "blocking of rock ") << m_jobs[job].id;
+            description << " (deadline " << getChosenAlternative(m_jobs[job]).deadline << ")";
+
+            return description.str();
+        }
+
+        vector<RotationJob> m_jobs;                       // Jobs of the turn.
+        vector<RotationJobAlternative> m_alternatives;    // Alternatives of all the jobs, a slice per job.
+        vector<int> m_order;                              // Job indexes ordered by deadline.
+        vector<int> m_greedy_order;                       // Jobs order at the start of the greedy pass of schedule().
+        int m_slack;                                      // Slack of the current schedule.
+        int m_late_job;                                   // Job with the smallest slack.
+};
+
+
+/**
+ * This class describes the manager that will handle rocks to block them. 
+ **/
+class RockManager
+{
+    public : 
+
+        /**
+            Rock manager constructor.
+
+            @param[in] map Map to work on with rocks.
+            @param[in] player_path Path the player will follow, to compute intersections with rocks.
+        **/
+        RockManager(Map* map, std::unordered_map<Vector2i,PathNode>* player_path) : m_map(map), m_player_path(player_path), m_turn(0), m_rocks(), m_rocks_index(), m_trajectories(),
+                                                                                                 m_diverged(), m_previous_options(), m_simulated_states(), m_collision_steps(), m_arrival_stamps(), m_arrival_counts(), m_arrival_stamp(0)
+        {}
+
+
+        RockManager() = delete;
+
+        /**
+            Rock manager destructor. Nothing special, pointers referenced in this class must not be destroyed by it.
+        **/
+        virtual ~RockManager() = default; 
+        
+        /**
+         * This method makes the known rocks progress one tile ahead (which keeps the model up to date at each iteration).
+         * Rocks reaching the end of their trajectory are crashed, so they are retired.
+         */
+        void updateRocksAhead()
+        {
+            int rock = 0;
+            
+            m_turn++;
+            
+            for (int r = 0; r < m_rocks.size(); r++)
+            {
+                m_rocks_index[getIndexKey(m_rocks.getTile(r), m_rocks.getEntry(r))] = -1;
+            }
+            
+            while (rock < m_rocks.size())
+            {
+                PathNode new_pos = m_trajectories.getNode(m_trajectories.getNext(m_trajectories.getState(m_rocks.getTile(rock), m_rocks.getEntry(rock))));
+                
+                if (new_pos.tile != nullptr)
+                {
+                    m_rocks.moveTo(rock, new_pos);
+                    rock++;
+                }
+                else
+                {
+                    m_rocks.retire(rock); // The last rock comes in this slot, it will be processed next.
+                }
+            }
+            
+            for (int r = 0; r < m_rocks.size(); r++)
+            {
+                m_rocks_index[getIndexKey(m_rocks.getTile(r), m_rocks.getEntry(r))] = r;
+            }
+        }
+        
+        /**
+         * This method takes a longer player path into account (partial paths of the ANYTIME solver) : trajectories are
+         * followed up to the new path tiles, which are rotated. Only the cache entries upstream of them are updated.
+         * 
+         * The rocks already known and not blocked yet are planned again : a rock that missed the old path may reach the new
+         * one, and blocking options may act on tiles the new path uses. Options already partly executed keep their progress.
+         */
+        void updatePlayerPath()
+        {
+            if (!m_trajectories.isBuilt())
+            {
+                return;
+            }
+
+            for (const pair<const Vector2i, PathNode> &position : *m_player_path)
+            {
+                if (!m_trajectories.isStopTile(position.second.tile))
+                {
+                    m_trajectories.invalidateTile(position.second.tile, true);
+                }
+            }
+            
+            for (int rock_id = 0; rock_id < m_rocks.size(); rock_id++)
+            {
+                if (isBlocked(rock_id))
+                {
+                    continue;
+                }
+                
+                m_previous_options.clear();
+                
+                for (int k = 0; k < m_rocks.getOptionsCount(rock_id); k++)
+                {
+                    m_previous_options.push_back(m_rocks.getOption(rock_id, k));
+                }
+                
+                m_rocks.clearOptions(rock_id);
+                planRock(rock_id);
+                
+                for (int k = 0; k < m_rocks.getOptionsCount(rock_id); k++)
+                {
+                    RockBlockingOption &option = m_rocks.getOption(rock_id, k);
+                    
+                    for (const RockBlockingOption &previous_option : m_previous_options)
+                    {
+                        if (previous_option.instruction.tile == option.instruction.tile && previous_option.instruction.action == option.instruction.action)
+                        {
+                            option.remaining_instructions = min(option.remaining_instructions, previous_option.remaining_instructions);
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * This method registers a rock if it doesn't already exists.
+         * 
+         * @param[in] rock_pos_x Rock X coordinate.
+         * @param[in] rock_pos_y Rock Y coordinate.
+         * @param[in] entering_direction Rock entering direction on the current tile.
+         * 
+         */
+        void processRock(int rock_pos_x, int rock_pos_y, Direction entering_direction)
+        {
+            Tile* rock_tile = m_map->getTileAt(rock_pos_x,rock_pos_y);
+            
+            if (rock_tile == nullptr)
+            {
+                return;
+            }
+            
+            if (!m_trajectories.isBuilt())
+            {
+                m_trajectories.build(m_map, *m_player_path);
+                m_diverged.assign(m_map->getSize().x * m_map->getSize().y, false);
+            }
+            
+            // 1- we check if the given position is part of an already existing rock.
+            int index_key = getIndexKey(rock_tile, entering_direction);
+            
+            if (index_key >= (int)m_rocks_index.size())
+            {
+                m_rocks_index.resize((m_map->getSize().x * m_map->getSize().y) * 4, -1);
+            }
+            
+            bool already_exists = m_rocks_index[index_key] != -1;
+            
+            if (already_exists)
+            {
+                m_rocks.setReportedTurn(m_rocks_index[index_key], m_turn);
+            }
+            
+            // 2 - If this is a new rock, we compute possible plans to block it, and we store SolverInstructions to be executed later on.
+            if (!already_exists)
+            {
+                int rock_id = m_rocks.addRock(PathNode(rock_tile, entering_direction));
+                
+                m_rocks_index[index_key] = rock_id;
+                m_rocks.setReportedTurn(rock_id, m_turn);
+                planRock(rock_id);
+            }
+        }
+        
+        /**
+         * This method removes the known rocks that the game didn't report this turn (to be called after processRock() for
+         * the reported rocks) : rocks destroyed by a collision, or that went another way than the model.
+         */
+        void retireUnreportedRocks()
+        {
+            int rock = 0;
+            
+            for (int r = 0; r < m_rocks.size(); r++)
+            {
+                m_rocks_index[getIndexKey(m_rocks.getTile(r), m_rocks.getEntry(r))] = -1;
+            }
+            
+            while (rock < m_rocks.size())
+            {
+                // Rocks on the player path are not processed by the caller.
+                if (m_rocks.getReportedTurn(rock) != m_turn && m_player_path->find(m_rocks.getTile(rock)->getPosition()) == m_player_path->end())
+                {
+                    m_rocks.retire(rock); // The last rock comes in this slot, it will be processed next.
+                }
+                else
+                {
+                    rock++;
+                }
+            }
+            
+            for (int r = 0; r < m_rocks.size(); r++)
+            {
+                m_rocks_index[getIndexKey(m_rocks.getTile(r), m_rocks.getEntry(r))] = r;
+            }
+        }
+        
+        /**
+         * This method adds a job to the scheduler for each rock to block, with the SolverInstructions stored during their
+         * registration by method processRock() as alternatives. Options are added in trajectory order, so the preferred
+         * alternative blocks the rock as soon as possible.
+         * Rocks for which every blocking tile has been passed are given up.
+         * 
+         * Rocks that another rock will destroy (see predictCollisions()) are left for this turn, if they can still be blocked
+         * on a tile past the collision in case it doesn't happen.
+         * 
+         * @param[inout] scheduler Scheduler of the current turn.
+         */
+        void addBlockingJobs(RotationScheduler &scheduler)
+        {
+            int colliding_rocks = 0;
+            
+            predictCollisions();
+            
+            for (int rock_id = 0; rock_id < m_rocks.size(); rock_id++)
+            {
+                if (!m_rocks.isToBlock(rock_id))
+                {
+                    continue;
+                }
+                
+                bool can_still_block = false;
+                int job = -1;
+                
+                if (m_collision_steps[rock_id] > 0 && hasBlockingOptionAfter(rock_id, m_collision_steps[rock_id]))
+                {
+                    colliding_rocks++;
+                    continue;
+                }
+                
+                for (int k = 0; k < m_rocks.getOptionsCount(rock_id); k++)
+                {
+                    RockBlockingOption &option = m_rocks.getOption(rock_id, k);
+                    
+                    if (option.deadline - m_turn > option.remaining_instructions) // If the instruction is still executable by acting on a tile ahead of the current rock tile.
+                    {
+                        can_still_block = true;
+                        
+                        if (!option.instruction.tile->containsPlayer())
+                        {
+                            if (job == -1)
+                            {
+                                job = scheduler.addJob(RotationJobSource::ROCK_BLOCKING, rock_id);
+                            }
+                            
+                            // The last instruction must be executed two turns before the rock reaches the tile.
+                            scheduler.addAlternative(option.deadline - 2, option.remaining_instructions, k);
+                        }
+                    }
+                }
+                
+                if (!can_still_block)
+                {
+                    m_rocks.giveUpRock(rock_id);
+                }
+            }
+            
+            if (colliding_rocks > 0)
+            {
+                cerr << "Rocks left to a collision: " << colliding_rocks << endl;
+            }
+        }
+        
+        /**
+         * @param[in] rock_id Slot of a rock.
+         * @param[in] option_index Index of a blocking option of the rock.
+         * 
+         * @returns The tile the blocking option acts on.
+         */
+        Tile* getBlockingTile(int rock_id, int option_index)
+        {
+            return m_rocks.getOption(rock_id, option_index).instruction.tile;
+        }
+        
+        /**
+         * This method performs rock blocking by executing one SolverInstruction of a blocking option.
+         * 
+         * @param[in] rock_id Slot of the rock to block.
+         * @param[in] option_index Index of the blocking option of the rock.
+         * 
+         * @returns The instruction to output.
+         */
+        SolverInstruction executeBlockingJob(int rock_id, int option_index)
+        {
+            RockBlockingOption &option = m_rocks.getOption(rock_id, option_index);
+            SolverInstruction* instruction = &option.instruction;
+            
+            bool is_player_path = m_player_path->find(instruction->tile->getPosition()) != m_player_path->end();
+        
+            if (is_player_path)
+            {
+                 instruction->tile->unlock();
+            }
+            
+            option.remaining_instructions--;
+            m_diverged[getTileIndex(instruction->tile)] = true; // The model doesn't follow the rotation.
+                            
+            if (is_player_path)
             {
-                return false;
+                 instruction->tile->lock();
             }
-            else if (start_tile->isLocked()) // Tile can't be moved.
+            
+            if (option.remaining_instructions == 0)
+            {
+                m_rocks.setSafe(rock_id);
+            }
+            
+            return *instruction;
+        }
+    
+    private :
+    
+        /**
+         * Gives the key of a rock state in the rocks index.
+         *
+         * @param[in] tile Tile the rock is in.
+         * @param[in] entering_direction Rock entering direction on the tile.
+         *
+         * @returns The index key : (y * map width + x) * 4 + entering direction.
+         */
+        int getIndexKey(Tile* tile, Direction entering_direction) const
+        {
+            Vector2i position = tile->getPosition();
+            
+            return (position.y * m_map->getSize().x + position.x) * 4 + entering_direction;
+        }
+        
+        /**
+         * Follows the trajectory of a rock without blocking options up to the player path, and stores the options to block it.
+         * The rock is marked safe if it doesn't reach the player path.
+         *
+         * @param[in] rock_id Rock slot in m_rocks.
+         */
+        void planRock(int rock_id)
+        {
+            PathNode rock_current_node(m_rocks.getTile(rock_id), m_rocks.getEntry(rock_id));
+            int current_distance_to_rock = 0;
+            int rock_state = m_trajectories.getState(rock_current_node.tile, rock_current_node.enter_direction);
+            int steps = 0;
+            bool has_full_path = false;
+            
+            // The rock never reaches player path : no need to follow it.
+            if (!m_trajectories.findStopAhead(rock_state, steps))
             {
-                output = start_tile->getOutput(entering_direction);
+                m_rocks.setSafe(rock_id);
+                has_full_path = true;
+            }
+            
+            // While we don't arrive to player path.
+            while (!has_full_path)
+            {
+                // Tiles that can't be rotated are skipped, the rock goes directly to the next one we can act on.
+                rock_state = m_trajectories.getRunEnd(rock_state, steps);
+                LAST_CRUSADE_COUNT(rock_steps, 1);
+                rock_current_node = m_trajectories.getNode(rock_state);
+                current_distance_to_rock += steps;
                 
-                if (output.tile == nullptr)
+                // #### The rock is already safe before reaching player path
+                if (rock_current_node.tile == nullptr)
                 {
-                    return false;
+                     m_rocks.setSafe(rock_id);
+                     has_full_path = true;
                 }
-                else
+                // #### We reached player path => we need to block the rock before (or on) this tile.
+                else if (m_player_path->find(rock_current_node.tile->getPosition()) != m_player_path->end())
                 {
-                    if (output.tile->getType() == TileType::EXIT)
-                    {
-                        return true;
-                    }
-                    else
-                    {
-                        kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));
-                        return computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
-                    }
+                     has_full_path = true;
+                     
+                     // We can act on the tile. It must be in its original orientation : blocking instructions are relative to it, 
+                     // and the tile gets locked once the rock is blocked, so the player path must not need to rotate it.
+                     if (!rock_current_node.tile->isLocked() && rock_current_node.tile->getRotation() == 0)
+                     {
+                        Direction player_direction = (*m_player_path)[rock_current_node.tile->getPosition()].enter_direction;
+                        
+                        addBlockingOption(rock_id, rock_current_node, player_direction, current_distance_to_rock);
+                     }
+                }
+                // #### We continue to follow rock's path.
+                else if (!rock_current_node.tile->isLocked()) // We can act on the tile.
+                {
+                    addBlockingOption(rock_id, rock_current_node, -1, current_distance_to_rock);
                 }
             }
-            else
+        }
+        
+        /**
+         * @param[in] rock_id Rock slot in m_rocks.
+         *
+         * @returns TRUE if all the instructions of a blocking option of the rock were executed, FALSE otherwise.
+         */
+        bool isBlocked(int rock_id)
+        {
+            for (int k = 0; k < m_rocks.getOptionsCount(rock_id); k++)
             {
-                bool found_exit = false;
-                bool pushed_position = false;
-                int path_position = kept_positions.size();
-               
-               // ============= Try DIRECT ===========
-                output = start_tile->getOutput(entering_direction);
-                
-                if (output.tile != nullptr)
+                if (m_rocks.getOption(rock_id, k).remaining_instructions == 0)
                 {
-                    //cerr << "---- (" << start_tile->getPosition().x << "," << start_tile->getPosition().y << ") Try DIRECT : ";
-                    kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));
-                    pushed_position = true;
-                    
-                    found_exit = computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
+                    return true;
+                }
+            }
+            
+            return false;
+        }
+        
+        /**
+         * Stores the cheapest turn of a tile that blocks a rock, if any, as a blocking option of the rock. Turns are read from
+         * the tile orientations tables, the tile is not rotated.
+         *
+         * @param[in] rock_id Rock slot in m_rocks.
+         * @param[in] rock_node Tile and direction the rock enters it by.
+         * @param[in] player_entry Direction the player enters the tile by, or -1 if the tile isn't on the player path.
+         * @param[in] distance Turns before the rock enters the tile.
+         */
+        void addBlockingOption(int rock_id, const PathNode &rock_node, int player_entry, int distance)
+        {
+            int blocking_quarters = TILE_ORIENTATIONS.blockingRotations(rock_node.tile->getType(), rock_node.tile->getRotation(), rock_node.enter_direction, player_entry);
+            
+            // LEFT, RIGHT, then LEFT LEFT : two instructions to execute => we must take care of them one tile before others.
+            for (int quarters : {3, 1, 2})
+            {
+                if (((blocking_quarters >> quarters) & 1) != 0)
+                {
+                    SolverInstruction instruction(rock_node.tile, quarters == 1 ? TileAction::ROTATE_RIGHT : TileAction::ROTATE_LEFT, distance);
+                    m_rocks.addBlockingOption(rock_id, instruction, quarters == 2 ? 2 : 1, m_turn + distance);
                     
-                    if (found_exit)
-                    {
-                        return true;
-                    }
+                    return;
                 }
+            }
+        }
+        
+        /**
+         * @returns The index of a tile in the per tile tables (row major).
+         */
+        int getTileIndex(Tile* tile) const
+        {
+            return tile->getPosition().y * m_map->getSize().x + tile->getPosition().x;
+        }
+        
+        /**
+         * Tells whether the rocks going through a tile are known to follow the model : the tile isn't on the player path
+         * (whose tiles wait for their rotations) and wasn't rotated to block a rock.
+         *
+         * @param[in] tile A map tile.
+         *
+         * @returns TRUE if the tile keeps its model rotation, FALSE otherwise.
+         */
+        bool isSteadyTile(Tile* tile) const
+        {
+            return !m_player_path->count(tile->getPosition()) && !m_diverged[getTileIndex(tile)];
+        }
+        
+        /**
+         * Predicts the collisions between the known rocks : all the rocks are moved along their trajectories together, and rocks
+         * entering the same tile at the same step are destroyed, as the game does. A rock is only followed while its moves are
+         * certain, i.e. through tiles that keep their model rotation (see isSteadyTile()) : rocks going through other tiles could
+         * be anywhere, they are left out (the rocks they may destroy instead are then blocked in time, see addBlockingJobs()).
+         *
+         * This is computed again every turn, so rotations changing a trajectory are taken into account on the next turn. The
+         * step at which each rock is destroyed by a collision, or -1, is stored in m_collision_steps.
+         */
+        void predictCollisions()
+        {
+            Vector2i size = m_map->getSize();
+            int tracked_rocks = 0;
+            
+            m_collision_steps.assign(m_rocks.size(), -1);
+            m_simulated_states.assign(m_rocks.size(), -1);
+            m_arrival_stamps.resize(size.x * size.y, 0);
+            m_arrival_counts.resize(size.x * size.y, 0);
+            
+            for (int rock = 0; rock < m_rocks.size(); rock++)
+            {
+                if (isSteadyTile(m_rocks.getTile(rock)))
+                {
+                    m_simulated_states[rock] = m_trajectories.getState(m_rocks.getTile(rock), m_rocks.getEntry(rock));
+                    tracked_rocks++;
+                }
+            }
+            
+            // Trajectories don't go through a tile twice.
+            for (int step = 1; tracked_rocks > 0 && step <= size.x * size.y; step++)
+            {
+                m_arrival_stamp++;
                 
-                
-                // ============= Try LEFT ===========                
-                if (!found_exit)
+                for (int rock = 0; rock < m_rocks.size(); rock++)
                 {
-                    start_tile->rotateAQuarterLeft();
+                    if (m_simulated_states[rock] < 0)
+                    {
+                        continue;
+                    }
                     
-                    SolverInstruction instruction(start_tile, TileAction::ROTATE_LEFT, path_position);
-                    instructions_to_follow.push_back(instruction);
+                    int next_state = m_trajectories.getNext(m_simulated_states[rock]);
+                    PathNode next = m_trajectories.getNode(next_state);
                     
+                    // Crashed, out of the map (exit line), entering a wall, or going through a tile out of the model.
+                    if (next.tile == nullptr || next.tile->getPosition().y == size.y - 1 || !next.tile->hasInputOnDirection(next.enter_direction) || !isSteadyTile(next.tile))
+                    {
+                        m_simulated_states[rock] = -1;
+                        tracked_rocks--;
+                        continue;
+                    }
                     
-                    output = start_tile->getOutput(entering_direction);
+                    int tile_index = getTileIndex(next.tile);
                     
-                    if (output.tile != nullptr)
-                    {                        
-                        if (!pushed_position)
-                        {
-                            kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));    
-                            pushed_position = true;  
-                        }  
-                        
-                        found_exit = computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
-                        
-                        if (found_exit)
-                        {
-                            return true;
-                        }
-                        else
-                        {
-                            start_tile->resetTile();
-                            instructions_to_follow.pop_back();
-                        }
-                    }
-                    else
+                    if (m_arrival_stamps[tile_index] != m_arrival_stamp)
                     {
-                        start_tile->resetTile();
-                        instructions_to_follow.pop_back();
+                        m_arrival_stamps[tile_index] = m_arrival_stamp;
+                        m_arrival_counts[tile_index] = 0;
                     }
+                    
+                    m_arrival_counts[tile_index]++;
+                    m_simulated_states[rock] = next_state;
                 }
                 
+                for (int rock = 0; rock < m_rocks.size(); rock++)
+                {
+                    if (m_simulated_states[rock] >= 0 && m_arrival_stamps[m_simulated_states[rock] / 4] == m_arrival_stamp && m_arrival_counts[m_simulated_states[rock] / 4] > 1)
+                    {
+                        m_collision_steps[rock] = step;
+                        m_simulated_states[rock] = -1;
+                        tracked_rocks--;
+                    }
+                }
+            }
+        }
+        
+        /**
+         * @param[in] rock_id Rock slot.
+         * @param[in] step Step at which the rock reaches a tile.
+         *
+         * @returns TRUE if the rock can still be blocked on a tile after this one, should it not be destroyed there.
+         */
+        bool hasBlockingOptionAfter(int rock_id, int step)
+        {
+            for (int k = 0; k < m_rocks.getOptionsCount(rock_id); k++)
+            {
+                RockBlockingOption &option = m_rocks.getOption(rock_id, k);
                 
-                // ============= Try RIGHT ===========   
-                if (!found_exit && !start_tile->isInvariantByLeftToRight())
+                // Once the collision is missed, the option must still be executable, with a turn to spare (see addBlockingJobs()).
+                if (option.deadline - m_turn - step > option.remaining_instructions + 1)
+                {
+                    return true;
+                }
+            }
+            
+            return false;
+        }
+    
+        Map* m_map; // Level map.
+        std::unordered_map<Vector2i,PathNode> *m_player_path; // Pointer to player path.
+        
+        // Turns elapsed since the start of the game. Blocking options deadlines are expressed in turns, so that they don't need
+        // to be decremented at each turn : the distance between a rock and a blocking tile is the option deadline minus m_turn.
+        //
+        // For example a distance of 1 tells that the rock can only be blocked by the tile 1 PathNode away from it, which means that 
+        // we must block it right now, otherwise we won't be able to block it.
+        int m_turn;
+        
+        // Rocks currently known, with their blocking options.
+        RockTable m_rocks;
+        
+        // Rocks index : tile and entering direction key (see getIndexKey()) => rock slot in m_rocks, or -1 if no rock is known there.
+        // It is rebuilt by updateRocksAhead() after rocks have moved, so that known rocks are found in O(1) when they are reported again.
+        vector<int> m_rocks_index;
+        
+        // Rocks trajectories, with player path tiles as stops. Built on the first processRock(), once the player path is known.
+        TrajectoryCache m_trajectories;
+        
+        // Tile index => TRUE if the tile was rotated to block a rock : the model doesn't follow these rotations.
+        vector<bool> m_diverged;
+        
+        // Buffer for updatePlayerPath() : blocking options of the rock planned again.
+        vector<RockBlockingOption> m_previous_options;
+        
+        // Collisions prediction (see predictCollisions()), kept between turns so that they don't allocate once big enough.
+        vector<int> m_simulated_states;   // Rock slot => state of the rock at the current step, or -1 if it isn't followed.
+        vector<int> m_collision_steps;    // Rock slot => step at which the rock is destroyed by a collision, or -1.
+        vector<int> m_arrival_stamps;     // Tile index => stamp of the last step a rock entered the tile.
+        vector<int> m_arrival_counts;     // Tile index => rocks entering the tile at the stamped step.
+        int m_arrival_stamp;
+};
+
+
+// Path finding mode (see PathSolverMode), number of threads of the portfolio modes (0 for one per hardware thread), and
+// time budget of the ANYTIME mode on each turn, in milliseconds.
+#ifndef LAST_CRUSADE_SOLVER_MODE
+#define LAST_CRUSADE_SOLVER_MODE ANYTIME
+#endif
+
+#ifndef LAST_CRUSADE_SOLVER_THREADS
+#define LAST_CRUSADE_SOLVER_THREADS 0
+#endif
+
+#ifndef LAST_CRUSADE_SOLVER_BUDGET_MS
+#define LAST_CRUSADE_SOLVER_BUDGET_MS 50
+#endif
+
+
+/**
+ * This class plays the turns of a level : the player path is found on the first turn, then rocks are followed and the
+ * rotations of the player path and of rock blocking are scheduled, one per turn.
+ */
+class TurnController
+{
+    public :
+
+        /**
+            Turn controller constructor.
+
+            @param[in] map Level map (exit line included).
+        **/
+        explicit TurnController(Map* map) : m_map(map), m_solver(map, PathSolverMode::LAST_CRUSADE_SOLVER_MODE, LAST_CRUSADE_SOLVER_THREADS, LAST_CRUSADE_SOLVER_BUDGET_MS), m_instructions(), 
+                                            m_executed_instructions(), m_final_player_path(), m_rock_tiles(), m_solved(false), m_previous_tile(nullptr), m_rock_manager(map, &m_final_player_path), 
+                                            m_scheduler(), m_instruction_index(0), m_player_advancement(0)
+        {}
+
+        TurnController() = delete;
+
+        /**
+            Turn controller destructor. The map is not destructed by this class.
+        **/
+        virtual ~TurnController() = default;
+
+        /**
+         * Plays a turn.
+         *
+         * @param[in] player_x Player X coordinate.
+         * @param[in] player_y Player Y coordinate.
+         * @param[in] player_direction Player entering direction on its tile.
+         * @param[in] rocks Rocks in the grid : their tile and entering direction.
+         * @param[out] instruction Instruction to output, if any.
+         *
+         * @returns TRUE if an instruction must be output, FALSE to wait.
+         */
+        bool playTurn(int player_x, int player_y, Direction player_direction, const vector<PathNode> &rocks, SolverInstruction &instruction)
+        {
+            LAST_CRUSADE_PHASE_BEGIN();
+
+            // ======================== PLAYER POS UPDATE ==========================
+            if (m_previous_tile != nullptr)
+            {
+                m_previous_tile->setContainsPlayer(false);
+            }
+
+            Tile* current_tile = m_map->getTileAt(player_x,player_y);
+
+            if (current_tile != nullptr)
+            {
+                current_tile->setContainsPlayer(true);
+            }
+
+            m_previous_tile = current_tile;
+            m_player_advancement++;
+            // =====================================================================
+
+            // ============================ PATH FINDING ===========================
+            // (executed once only)
+            if (!m_solved)
+            {
+                m_solver.resolvePathToExit(player_x, player_y, player_direction, m_instructions, m_final_player_path);
+                m_executed_instructions.assign(m_instructions.size(), false);
+
+                // Turns the player path leaves for rock blocking, at its tightest point.
+                cerr << "Player path: " << m_instructions.size() << " rotation(s), slack " << m_solver.getSlack() << endl;
+
+                m_solved = true;
+            }
+            else if (m_solver.hasPartialPath())
+            {
+                // The path found within the time budget is extended, before the player gets to its end.
+                int pending_instructions = count(m_executed_instructions.begin(), m_executed_instructions.end(), false);
+
+                m_solver.extendPath(m_player_advancement, PathNode(current_tile, player_direction), pending_instructions, m_instructions, m_final_player_path);
+                m_executed_instructions.resize(m_instructions.size(), false);
+                m_rock_manager.updatePlayerPath();
+
+                cerr << "Player path extended: " << m_instructions.size() << " rotation(s)" << endl;
+            }
+
+            LAST_CRUSADE_PHASE_END(PATH_SOLVING);
+            // =====================================================================
+
+            // ============================ ROCKS UPDATE ===========================
+            m_rock_tiles.clear();
+            m_rock_manager.updateRocksAhead();
+
+            for (const PathNode &rock : rocks)
+            {
+                if (rock.tile == nullptr)
+                {
+                    continue;
+                }
+
+                Vector2i rock_pos = rock.tile->getPosition();
+                m_rock_tiles.insert(rock_pos);
+
+                if (m_final_player_path.find(rock_pos) == m_final_player_path.end())
+                {
+                    m_rock_manager.processRock(rock_pos.x, rock_pos.y, rock.enter_direction);
+                }
+            }
+
+            m_rock_manager.retireUnreportedRocks();
+
+            LAST_CRUSADE_PHASE_END(ROCKS_UPDATE);
+            // =====================================================================
+
+            // ====================== INSTRUCTION DECISION =========================
+            m_scheduler.clear();
+
+            // Sometimes player path tiles are locked by rock blocking algorithm when needed.
+            // But when it arrives, we are sure that the tile is already well placed.
+            for (int k = m_instruction_index; k < (int)m_instructions.size(); k++)
+            {
+                if (!m_executed_instructions[k] && m_instructions[k].path_position < m_player_advancement)
+                {
+                    m_executed_instructions[k] = true; // Dropped : the player is already on its tile, or past it.
+                }
+                else if (!m_instructions[k].tile->isLocked() && !m_executed_instructions[k])
+                {
+                    m_scheduler.addJob(RotationJobSource::PLAYER_PATH, k);
+                    m_scheduler.addAlternative(m_instructions[k].path_position, 1, k); // The tile must be rotated before the player enters it.
+                }
+            }
+
+            while (m_instruction_index < (int)m_instructions.size() && m_executed_instructions[m_instruction_index])
+            {
+                m_instruction_index++;
+            }
+
+            m_rock_manager.addBlockingJobs(m_scheduler);
+            m_scheduler.schedule(m_player_advancement);
+
+            // The first job in deadline order whose tile can be rotated this turn (no rock nor player on it) is executed.
+            int job_rank = 0;
+
+            while (job_rank < m_scheduler.getJobsCount())
+            {
+                const RotationJob &job = m_scheduler.getJob(job_rank);
+                Tile* job_tile = job.source == RotationJobSource::ROCK_BLOCKING ? m_rock_manager.getBlockingTile(job.id, m_scheduler.getChosenAlternative(job).payload) : m_instructions[job.id].tile;
+
+                if (job_tile != current_tile && m_rock_tiles.find(job_tile->getPosition()) == m_rock_tiles.end())
+                {
+                    break;
+                }
+
+                job_rank++;
+            }
+
+            bool has_instruction = job_rank < m_scheduler.getJobsCount();
+
+            if (has_instruction)
+            {
+                const RotationJob &job = m_scheduler.getJob(job_rank);
+
+                if (job.source == RotationJobSource::ROCK_BLOCKING)
                 {
-                    start_tile->rotateAQuarterRight();
-                    
-                    SolverInstruction instruction(start_tile, TileAction::ROTATE_RIGHT, path_position);
-                    instructions_to_follow.push_back(instruction);
-                
-                    output = start_tile->getOutput(entering_direction);
-                    
-                    if (output.tile != nullptr)
-                    {
-                        if (!pushed_position)
-                        {
-                            kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));    
-                            pushed_position = true;  
-                        }                  
-                                                
-                        found_exit = computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
-                        
-                        if (found_exit)
-                        {
-                            return true;
-                        }
-                        else
-                        {
-                            start_tile->resetTile();
-                            instructions_to_follow.pop_back();
-                        }
-                    }
-                    else
+                    instruction = m_rock_manager.executeBlockingJob(job.id, m_scheduler.getChosenAlternative(job).payload);
+
+                    if (m_solver.hasPartialPath()) // The map model doesn't follow this rotation, so the path must avoid the tile.
                     {
-                        start_tile->resetTile();
-                        instructions_to_follow.pop_back();
-                        
+                        m_solver.excludeTile(instruction.tile);
                     }
                 }
-                
-                
-                 // ============= Try LEFT LEFT ===========
-                if (!found_exit && !start_tile->isInvariantBy2Quarters())
+                else
                 {
-                    start_tile->rotate2Quarters();
-                    
-                    SolverInstruction instruction(start_tile, TileAction::ROTATE_LEFT, path_position);
-                    instructions_to_follow.push_back(instruction);
-                    instructions_to_follow.push_back(instruction);
-                    
-                    output = start_tile->getOutput(entering_direction);
-                    
-                    if (output.tile != nullptr)
-                    {
-                        if (!pushed_position)
-                        {
-                            kept_positions.insert(make_pair(start_tile->getPosition(), PathNode(start_tile, entering_direction)));    
-                            pushed_position = true;  
-                        }             
-                        
-                        found_exit = computePathToExit(output.tile, output.enter_direction, instructions_to_follow, kept_positions);
-                        
-                        if (found_exit)
-                        {
-                            return true;
-                        }
-                        else
-                        {
-                            start_tile->resetTile();
-                            instructions_to_follow.pop_back();
-                            instructions_to_follow.pop_back();
-                        }
-                    }
-                    else
+                    // Solving player path
+                    instruction = m_instructions[job.id];
+                    m_executed_instructions[job.id] = true;
+
+                    while (m_instruction_index < (int)m_instructions.size() && m_executed_instructions[m_instruction_index])
                     {
-                        start_tile->resetTile();
-                        instructions_to_follow.pop_back();
-                        instructions_to_follow.pop_back();
-                        
+                        m_instruction_index++;
                     }
                 }
-                
-                
-                if (!found_exit)
-                {
-                    kept_positions.erase(start_tile->getPosition());
-                    
-                    return false;
-                }
             }
+
+            LAST_CRUSADE_PHASE_END(SCHEDULING);
+            LAST_CRUSADE_REPORT(m_player_advancement);
+            // =====================================================================
+
+            return has_instruction;
         }
-    
+
+        /**
+         * @param[in] position A position as given by the game : "TOP", "LEFT", "RIGHT" or "BOTTOM".
+         *
+         * @returns The corresponding direction.
+         */
+        static Direction parseDirection(const string &position)
+        {
+            if (position == "BOTTOM")
+            {
+                return Direction::BOTTOM;
+            }
+            else if (position == "LEFT")
+            {
+                return Direction::LEFT;
+            }
+            else if (position == "RIGHT")
+            {
+                return Direction::RIGHT;
+            }
+
+            return Direction::TOP;
+        }
+
+    private :
         Map* m_map;
+        PathSolver m_solver;
+        std::vector<SolverInstruction> m_instructions;
+        std::vector<bool> m_executed_instructions;              // Player path instructions already output (they can be delayed by rocks on their tile).
+        std::unordered_map<Vector2i,PathNode> m_final_player_path;
+        std::unordered_set<Vector2i> m_rock_tiles;              // Tiles that hold a rock this turn, they can't be rotated.
+        bool m_solved;
+        Tile* m_previous_tile;
+        RockManager m_rock_manager;
+        RotationScheduler m_scheduler;
+        int m_instruction_index;                                // First player path instruction not executed yet.
+        int m_player_advancement;                               // Turn number, from 1.
 };
 
+
+#ifdef LAST_CRUSADE_REFEREE
+// ============================================================================
+//                              OFFLINE REFEREE
+// ============================================================================
+// Define LAST_CRUSADE_REFEREE to build a stress benchmark instead of the Codingame program : seeded solvable levels are
+// generated, and played in-process against the turn controller. Usage :
+//      ./referee [games] [seed] [width] [height] [lock density] [rock rate] [corridors]
+// A width or height of 0 is drawn in [4,13] per game, a negative rock rate is drawn in {0, 0.15, 0.3, 0.5} per game.
+// A rock rate of 1 or more spawns that many rocks per turn, else it is the probability to spawn one rock per turn.
+// With corridors set to 1, the tiles out of the player path are locked horizontal tiles : rocks spawned on the sides
+// cross whole lines, so that many of them are known at once (e.g. ./referee 10 0 100 100 0 20 1 for a rock-heavy run).
+// The allocations made while a level is loaded in the map model are counted (e.g. ./referee 10 0 500 500 for large maps).
+// The portfolio path finding modes are compared to the sequential one on the same levels with ./referee solvers, see
+// benchmarkSolvers().
+
+#include <random>
+#include <numeric>
+#include <new>
+#include <cstdlib>
+
 /**
- * This class describes the manager that will handle rocks to block them. 
- **/
-class RockManager
+ * Allocations made by the program : operator new is replaced in the referee build to count them.
+ */
+static std::atomic<long long> ALLOCATIONS_COUNT(0);
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // GCC can't tell the replaced new and delete below match.
+#endif
+
+void* operator new(std::size_t size)
 {
-    public : 
+    ALLOCATIONS_COUNT++;
+    void* memory = std::malloc(size);
+
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+/**
+ * Game rules, as the referee applies them (independently of the solver's tiles).
+ */
+class GameRules
+{
+    public :
 
         /**
-            Rock manager constructor.
+         * @param[in] type Tile type (0 to 13).
+         * @param[in] input Entering direction.
+         *
+         * @returns The output direction, or -1 if there is no path from this input.
+         */
+        static int getOutput(int type, int input)
+        {
+            static const int outputs[14][4] =
+            {
+                // TOP, RIGHT, BOTTOM, LEFT
+                {-1, -1, -1, -1},
+                {BOTTOM, BOTTOM, -1, BOTTOM},
+                {-1, LEFT, -1, RIGHT},
+                {BOTTOM, -1, -1, -1},
+                {LEFT, BOTTOM, -1, -1},
+                {RIGHT, -1, -1, BOTTOM},
+                {-1, LEFT, -1, RIGHT},
+                {BOTTOM, BOTTOM, -1, -1},
+                {-1, BOTTOM, -1, BOTTOM},
+                {BOTTOM, -1, -1, BOTTOM},
+                {LEFT, -1, -1, -1},
+                {RIGHT, -1, -1, -1},
+                {-1, BOTTOM, -1, -1},
+                {-1, -1, -1, BOTTOM}
+            };
+
+            return outputs[type][input];
+        }
 
-            @param[in] map Map to work on with rocks.
-            @param[in] player_path Path the player will follow, to compute intersections with rocks.
-        **/
-        RockManager(Map* map, std::unordered_map<Vector2i,PathNode>* player_path) : m_player_path(player_path), m_map(map), m_rocks_safety(), m_rocks_blocking_instructions(), m_rocks_current_node(), m_rocks_priorities()
-        {}
+        /**
+         * @param[in] type Tile type (0 to 13).
+         * @param[in] action Rotation applied to the tile.
+         *
+         * @returns The type of the tile once rotated.
+         */
+        static int rotate(int type, TileAction action)
+        {
+            static const int right_of[14] = {0, 1, 3, 2, 5, 4, 7, 8, 9, 6, 11, 12, 13, 10};
+            static const int left_of[14] = {0, 1, 3, 2, 5, 4, 9, 6, 7, 8, 13, 10, 11, 12};
 
+            return action == TileAction::ROTATE_RIGHT ? right_of[type] : left_of[type];
+        }
 
-        RockManager() = delete;
+        /**
+         * @param[in] direction A direction.
+         *
+         * @returns The move of one tile in this direction.
+         */
+        static Vector2i getDelta(int direction)
+        {
+            static const Vector2i deltas[4] = {Vector2i(0,-1), Vector2i(1,0), Vector2i(0,1), Vector2i(-1,0)};
+
+            return deltas[direction];
+        }
+};
+
+/**
+ * A generated level. It's ok to let the fields public here, because this class is only a data structure.
+ */
+class Level
+{
+    public :
+        Level() : width(0), height(0), types(), locked(), start_x(0), exit_x(0) {}
+        virtual ~Level() = default;
+
+        int width;
+        int height;
+        std::vector<int> types;                 // Row major tile types.
+        std::vector<bool> locked;               // Row major locks.
+        int start_x;                            // Player start on the first line.
+        int exit_x;                             // Exit under the last line.
+};
+
+/**
+ * This class generates solvable levels : a path is carved line by line from the start to the exit, and its tiles are
+ * scrambled by no more rotations than the turns left to fix them.
+ */
+class LevelGenerator
+{
+    public :
 
         /**
-            Rock manager destructor. Nothing special, pointers referenced in this class must not be destroyed by it.
+            Level generator constructor.
+
+            @param[in] random Random engine, shared with the referee so that a seed describes a whole game.
         **/
-        virtual ~RockManager() = default; 
-        
+        explicit LevelGenerator(std::mt19937 &random) : m_random(random) {}
+
+        LevelGenerator() = delete;
+
         /**
-         * This method makes the known rocks progress one tile ahead (which keeps the model up to date at each iteration).
+            Level generator destructor.
+        **/
+        virtual ~LevelGenerator() = default;
+
+        /**
+         * Generates a level.
+         *
+         * @param[in] width Columns count.
+         * @param[in] height Lines count.
+         * @param[in] lock_density Probability for a tile out of the path to be locked.
+         * @param[in] corridors TRUE to make the tiles out of the path locked horizontal tiles (TYPE2), see the usage above.
+         *
+         * @returns The generated level.
          */
-        void updateRocksAhead()
+        Level generate(int width, int height, double lock_density, bool corridors = false)
         {
-            for (auto &p : m_rocks_current_node)
+            Level level;
+            level.width = width;
+            level.height = height;
+            level.types.resize(width*height);
+            level.locked.resize(width*height);
+
+            for (int k = 0; k < width*height; k++)
             {
-                PathNode new_pos = p.second.tile->getOutput(p.second.enter_direction);
-                
-                if (new_pos.tile != nullptr)
+                level.types[k] = corridors ? (int)TileType::TYPE2 : drawInt(0, 13);
+                level.locked[k] = corridors || drawReal() < lock_density;
+            }
+
+            level.start_x = drawInt(0, width-1);
+            level.exit_x = drawInt(0, width-1);
+
+            // Path carving : each line is crossed horizontally up to a random column, then left by the bottom.
+            std::vector<std::pair<Vector2i,std::pair<int,int>>> path; // tile, input and output directions.
+            int x = level.start_x, input = Direction::TOP;
+
+            for (int y = 0; y < height; y++)
+            {
+                int target = y == height-1 ? level.exit_x : drawInt(0, width-1);
+
+                while (x != target)
                 {
-                    p.second = new_pos;
+                    int output = target > x ? Direction::RIGHT : Direction::LEFT;
+                    path.push_back(make_pair(Vector2i(x,y), make_pair(input, output)));
+                    x += GameRules::getDelta(output).x;
+                    input = (output + 2) % 4;
                 }
+
+                path.push_back(make_pair(Vector2i(x,y), make_pair(input, (int)Direction::BOTTOM)));
+                input = Direction::TOP;
             }
-            
-            for (auto &p : m_rocks_blocking_instructions)
+
+            // Path tiles : a fitting type, scrambled within the rotations budget (one rotation per turn).
+            int budget = 0;
+
+            for (int k = 0; k < (int)path.size(); k++)
             {
-                if (!m_rocks_safety[p.first])
+                std::vector<int> candidates;
+
+                for (int type = 1; type < 14; type++)
                 {
-                    for (auto &v : p.second)
+                    if (GameRules::getOutput(type, path[k].second.first) == path[k].second.second)
                     {
-                        v.first--;
+                        candidates.push_back(type);
                     }
                 }
+
+                int type = candidates[drawInt(0, candidates.size()-1)];
+                int scrambled = type;
+                int cost = k > 0 ? drawInt(0, 2) : 0;
+
+                if (budget + cost > k)
+                {
+                    cost = 0;
+                }
+
+                if (cost == 1)
+                {
+                    scrambled = GameRules::rotate(type, drawInt(0, 1) == 0 ? TileAction::ROTATE_RIGHT : TileAction::ROTATE_LEFT);
+                }
+                else if (cost == 2)
+                {
+                    scrambled = GameRules::rotate(GameRules::rotate(type, TileAction::ROTATE_RIGHT), TileAction::ROTATE_RIGHT);
+                }
+
+                if (scrambled == type)
+                {
+                    cost = 0; // symmetric tile
+                }
+
+                budget += cost;
+
+                int index = path[k].first.y*width + path[k].first.x;
+                level.types[index] = scrambled;
+                level.locked[index] = k == 0 || (cost == 0 && drawReal() < 0.4);
             }
-            
-            for (auto &p : m_rocks_priorities)
-            {
-                p.second--;
-            }
+
+            return level;
         }
-        
+
+    private :
+
         /**
-         * This method registers a rock if it doesn't already exists.
-         * 
-         * @param[in] rock_pos_x Rock X coordinate.
-         * @param[in] rock_pos_y Rock Y coordinate.
-         * @param[in] entering_direction Rock entering direction on the current tile.
-         * 
+         * @returns A random integer in [min,max].
          */
-        void processRock(int rock_pos_x, int rock_pos_y, Direction entering_direction)
+        int drawInt(int min, int max)
         {
-            bool already_exists = false;
-            Vector2i rock_pos(rock_pos_x,rock_pos_y);
-            
-            // 1- we check if the given position is part of an already existing rock.
-            for (auto p : m_rocks_current_node)
+            return std::uniform_int_distribution<int>(min, max)(m_random);
+        }
+
+        /**
+         * @returns A random real in [0,1[.
+         */
+        double drawReal()
+        {
+            return std::uniform_real_distribution<double>(0.0, 1.0)(m_random);
+        }
+
+        std::mt19937 &m_random;
+};
+
+/**
+ * Loads a level in the map model.
+ *
+ * @param[in] level The level.
+ * @param[out] level_map Map of the level size, with no tiles yet.
+ */
+void loadLevel(const Level &level, Map &level_map)
+{
+    for (int y = 0; y < level.height; y++)
+    {
+        for (int x = 0; x < level.width; x++)
+        {
+            level_map.addTile(x, y, (TileType)level.types[y*level.width + x], level.locked[y*level.width + x] && level.types[y*level.width + x] != 0);
+        }
+    }
+
+    level_map.addExitLine(level.exit_x);
+}
+
+/**
+ * Possible outcomes of a game.
+ */
+enum GameOutcome{WIN = 0, LOSE = 1, ROCK = 2, ILLEGAL = 3, TIMEOUT = 4};
+
+/**
+ * This class plays a level against the turn controller : Indy and the rocks are moved after each command, as the
+ * Codingame referee does.
+ */
+class OfflineReferee
+{
+    public :
+
+        /**
+            Offline referee constructor.
+
+            @param[in] random Random engine, for rocks spawning.
+            @param[in] max_turns Turns after which the game is a timeout.
+        **/
+        OfflineReferee(std::mt19937 &random, int max_turns) : m_random(random), m_max_turns(max_turns) {}
+
+        OfflineReferee() = delete;
+
+        /**
+            Offline referee destructor.
+        **/
+        virtual ~OfflineReferee() = default;
+
+        /**
+         * Plays a game.
+         *
+         * @param[in] level The level (modified by the game).
+         * @param[in] rock_rate Rocks spawning rate.
+         * @param[out] latencies Time spent in every turn by the controller, in ms.
+         * @param[out] rock_counts Rocks given to the controller in every turn.
+         * @param[out] load_latency Time spent loading the level in the map model, in ms.
+         * @param[out] load_allocations Allocations made while loading the level in the map model.
+         *
+         * @returns The game outcome.
+         */
+        GameOutcome play(Level &level, double rock_rate, std::vector<double> &latencies, std::vector<int> &rock_counts, double &load_latency, long long &load_allocations)
+        {
+            long long allocations = ALLOCATIONS_COUNT;
+            std::chrono::steady_clock::time_point load_start = std::chrono::steady_clock::now();
+            Map level_map(level.width, level.height);
+            loadLevel(level, level_map);
+
+            load_latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+            load_allocations = ALLOCATIONS_COUNT - allocations;
+
+            TurnController controller(&level_map);
+            SolverInstruction instruction;
+            std::vector<PathNode> rock_nodes;
+            std::vector<std::pair<Vector2i,int>> rocks;         // position and entering direction.
+            Vector2i player(level.start_x, 0);
+            int player_input = Direction::TOP;
+
+            for (int turn = 0; turn < m_max_turns; turn++)
             {
-                if (p.second.tile != nullptr && p.second.tile->getPosition() == rock_pos
-                    && p.second.enter_direction == entering_direction) 
+                spawnRocks(level, rock_rate, player, rocks);
+
+                rock_nodes.clear();
+
+                for (const std::pair<Vector2i,int> &rock : rocks)
+                {
+                    rock_nodes.push_back(PathNode(level_map.getTileAt(rock.first.x, rock.first.y), (Direction)rock.second));
+                }
+
+                rock_counts.push_back(rock_nodes.size());
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                bool has_instruction = controller.playTurn(player.x, player.y, (Direction)player_input, rock_nodes, instruction);
+                latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+                // Command
+                if (has_instruction)
                 {
-                    already_exists = true;
-                    break;
+                    Vector2i target = instruction.tile->getPosition();
+                    bool illegal = target.x < 0 || target.x >= level.width || target.y < 0 || target.y >= level.height || target == player;
+
+                    for (const std::pair<Vector2i,int> &rock : rocks)
+                    {
+                        illegal = illegal || rock.first == target;
+                    }
+
+                    if (illegal || level.locked[target.y*level.width + target.x])
+                    {
+                        return GameOutcome::ILLEGAL;
+                    }
+
+                    level.types[target.y*level.width + target.x] = GameRules::rotate(level.types[target.y*level.width + target.x], instruction.action);
                 }
-            }
-            
-            // 2 - If this is a new rock, we compute possible plans to block it, and we store SolverInstructions to be executed later on.
-            if (!already_exists)
-            {
-                int rock_id = m_rocks_safety.size();
-                PathNode rock_current_node(m_map->getTileAt(rock_pos_x,rock_pos_y), entering_direction);
-                
-                m_rocks_safety[rock_id] = false;
-                m_rocks_priorities[rock_id] = numeric_limits<int>::max();
-                m_rocks_current_node[rock_id] = rock_current_node;
-                
-                int current_distance_to_rock = 0;
-                bool has_full_path = false;
-                
-                // While we don't arrive to player path.
-                while (!has_full_path)
+
+                // Indy
+                int output = GameRules::getOutput(level.types[player.y*level.width + player.x], player_input);
+
+                if (output == -1)
                 {
-                    rock_current_node = rock_current_node.tile->getOutput(rock_current_node.enter_direction);
-                    current_distance_to_rock++;
-                    
-                    // #### The rock is already safe before reaching player path
-                    if (rock_current_node.tile == nullptr)
+                    return GameOutcome::LOSE;
+                }
+
+                if (player.x == level.exit_x && player.y == level.height-1 && output == Direction::BOTTOM)
+                {
+                    return GameOutcome::WIN;
+                }
+
+                if (!move(level, player, player_input, output))
+                {
+                    return GameOutcome::LOSE;
+                }
+
+                // Rocks : rocks that stop or collide are destroyed.
+                std::vector<std::pair<Vector2i,int>> moved_rocks;
+
+                for (std::pair<Vector2i,int> &rock : rocks)
+                {
+                    output = GameRules::getOutput(level.types[rock.first.y*level.width + rock.first.x], rock.second);
+
+                    if (output != -1 && move(level, rock.first, rock.second, output))
                     {
-                         m_rocks_safety[rock_id] = true;
-                         has_full_path = true;
+                        moved_rocks.push_back(rock);
                     }
-                    // #### We reached player path => we need to block the rock before (or on) this tile.
-                    else if (m_player_path->find(rock_current_node.tile->getPosition()) != m_player_path->end())
+                }
+
+                rocks.clear();
+
+                for (const std::pair<Vector2i,int> &rock : moved_rocks)
+                {
+                    int collisions = 0;
+
+                    for (const std::pair<Vector2i,int> &other : moved_rocks)
                     {
-                         has_full_path = true;
-                         
-                         Direction player_direction = (*m_player_path)[rock_current_node.tile->getPosition()].enter_direction;
-                         
-                         if (!rock_current_node.tile->isLocked()) // We can act on the tile.
-                         {
-                            // 1 - ===== TRY BLOCKING BY ROTATING LEFT =====
-                            rock_current_node.tile->rotateAQuarterLeft();
-                            
-                            if (!rock_current_node.tile->hasInputOnDirection(rock_current_node.enter_direction) && rock_current_node.tile->hasInputOnDirection(player_direction))
-                            {
-                                SolverInstruction instruction(rock_current_node.tile, TileAction::ROTATE_LEFT, current_distance_to_rock);
-                                
-                                queue<SolverInstruction> solve_instructions;
-                                solve_instructions.push(instruction);
-                                
-                                m_rocks_blocking_instructions[rock_id].push_back(make_pair(current_distance_to_rock, move(solve_instructions)));
-                                m_rocks_priorities[rock_id] = current_distance_to_rock;
-                            }
-                            else
-                            {
-                                // 2 - ===== TRY BLOCKING BY ROTATING RIGHT =====
-                                rock_current_node.tile->resetTile();
-                                
-                                rock_current_node.tile->rotateAQuarterRight();
-                            
-                                if (!rock_current_node.tile->hasInputOnDirection(rock_current_node.enter_direction) && rock_current_node.tile->hasInputOnDirection(player_direction))
-                                {
-                                    SolverInstruction instruction(rock_current_node.tile, TileAction::ROTATE_RIGHT, current_distance_to_rock);
-                                
-                                    queue<SolverInstruction> solve_instructions;
-                                    solve_instructions.push(instruction);
-                                    
-                                    m_rocks_blocking_instructions[rock_id].push_back(make_pair(current_distance_to_rock, move(solve_instructions)));
-                                    m_rocks_priorities[rock_id] = current_distance_to_rock;
-                                }
-                                else
-                                {
-                                    // 3 - ===== TRY BLOCKING BY INVERTING TILE =====
-                                    rock_current_node.tile->resetTile();
-                                    
-                                    rock_current_node.tile->rotate2Quarters();
-                            
-                                    if (!rock_current_node.tile->hasInputOnDirection(rock_current_node.enter_direction) && rock_current_node.tile->hasInputOnDirection(player_direction))
-                                    {
-                                        SolverInstruction instruction(rock_current_node.tile, TileAction::ROTATE_LEFT, current_distance_to_rock);
-                                
-                                        queue<SolverInstruction> solve_instructions;
-                                        solve_instructions.push(instruction);
-                                        solve_instructions.push(instruction);
-                                        
-                                        m_rocks_blocking_instructions[rock_id].push_back(make_pair(current_distance_to_rock, move(solve_instructions)));
-                                        m_rocks_priorities[rock_id] = current_distance_to_rock-1; // Two instructions to execute => we must take care of them one tile before others.
-                                    }
-                                }
-                            }
-                        }
+                        collisions += other.first == rock.first ? 1 : 0;
                     }
-                    // #### We continue to follow rock's path.
-                    else
+
+                    if (collisions == 1)
                     {
-                        if (!rock_current_node.tile->isLocked()) // We can act on the tile.
+                        if (rock.first == player)
                         {
-                            // 1 - ===== TRY BLOCKING BY ROTATING LEFT =====
-                            rock_current_node.tile->rotateAQuarterLeft();
-                            
-                            if (!rock_current_node.tile->hasInputOnDirection(rock_current_node.enter_direction))
-                            {
-                                SolverInstruction instruction(rock_current_node.tile, TileAction::ROTATE_LEFT, current_distance_to_rock);
-                                
-                                queue<SolverInstruction> solve_instructions;
-                                solve_instructions.push(instruction);
-                                
-                                m_rocks_blocking_instructions[rock_id].push_back(make_pair(current_distance_to_rock, move(solve_instructions)));
-                                m_rocks_priorities[rock_id] = current_distance_to_rock;
-                            }
-                            else
-                            {
-                                 // 2 - ===== TRY BLOCKING BY ROTATING RIGHT =====
-                                rock_current_node.tile->resetTile();
-                                
-                                rock_current_node.tile->rotateAQuarterRight();
-                            
-                                if (!rock_current_node.tile->hasInputOnDirection(rock_current_node.enter_direction))
-                                {
-                                    SolverInstruction instruction(rock_current_node.tile, TileAction::ROTATE_RIGHT, current_distance_to_rock);
-                                
-                                    queue<SolverInstruction> solve_instructions;
-                                    solve_instructions.push(instruction);
-                                    
-                                    m_rocks_blocking_instructions[rock_id].push_back(make_pair(current_distance_to_rock, move(solve_instructions)));
-                                    m_rocks_priorities[rock_id] = current_distance_to_rock;
-                                }
-                                else
-                                {
-                                    // 3 - ===== TRY BLOCKING BY INVERTING TILE =====
-                                    rock_current_node.tile->resetTile();
-                                    
-                                    rock_current_node.tile->rotate2Quarters();
-                            
-                                    if (!rock_current_node.tile->hasInputOnDirection(rock_current_node.enter_direction))
-                                    {
-                                        SolverInstruction instruction(rock_current_node.tile, TileAction::ROTATE_LEFT, current_distance_to_rock);
-                                
-                                        queue<SolverInstruction> solve_instructions;
-                                        solve_instructions.push(instruction);
-                                        solve_instructions.push(instruction);
-                                        
-                                        m_rocks_blocking_instructions[rock_id].push_back(make_pair(current_distance_to_rock, move(solve_instructions)));
-                                        m_rocks_priorities[rock_id] = current_distance_to_rock-1; // Two instructions to execute => we must take care of them one tile before others.
-                                    }
-                                }
-                            }
-                            
-                        
-                            rock_current_node.tile->resetTile();
+                            return GameOutcome::ROCK;
                         }
+
+                        rocks.push_back(rock);
                     }
                 }
-                
             }
+
+            return GameOutcome::TIMEOUT;
         }
-        
+
+    private :
+
         /**
-         * This method performs rock blocking by executing SolverInstructions that have been stored for each rock path during their registration by method processRock();
-         * 
-         * @returns TRUE if we found an instruction to execute to block a rock and executed it. FALSE if we did nothing.
+         * Moves a falling object to its next tile.
+         *
+         * @param[in] level The level.
+         * @param[in,out] position Object position.
+         * @param[in,out] input Object entering direction.
+         * @param[in] output Object output direction on its current tile.
+         *
+         * @returns TRUE if the object could enter the next tile, FALSE if it is lost.
          */
-        bool processRockInterception()
+        bool move(const Level &level, Vector2i &position, int &input, int output)
         {
-            int min_priority = numeric_limits<int>::max();
-            int rock_id = -1;
-            
-            // 1 - Let's find the most problematic rock to block.
-            for (auto p : m_rocks_priorities)
+            Vector2i delta = GameRules::getDelta(output);
+            Vector2i next(position.x + delta.x, position.y + delta.y);
+            int next_input = (output + 2) % 4;
+
+            if (next.x < 0 || next.x >= level.width || next.y < 0 || next.y >= level.height
+                || !hasInput(level.types[next.y*level.width + next.x], next_input))
             {
-                if (p.second < min_priority && !m_rocks_safety[p.first])
-                {
-                    min_priority = p.second;
-                    rock_id = p.first;
-                }
+                return false;
             }
-            
-            SolverInstruction* instruction = nullptr;
-            string action_str = "";
-            bool has_moved_tile = false;
-            
-            if (rock_id != -1)
+
+            position = next;
+            input = next_input;
+
+            return true;
+        }
+
+        /**
+         * @returns TRUE if the given tile type has a path from the given input.
+         */
+        bool hasInput(int type, int input) const
+        {
+            return GameRules::getOutput(type, input) != -1;
+        }
+
+        /**
+         * Spawns rocks on the map borders, on free tiles with a path from the border.
+         */
+        void spawnRocks(const Level &level, double rock_rate, const Vector2i &player, std::vector<std::pair<Vector2i,int>> &rocks)
+        {
+            int count = rock_rate >= 1.0 ? (int)rock_rate : (rock_rate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(m_random) < rock_rate ? 1 : 0);
+
+            for (int k = 0; k < count; k++)
             {
-                // Let's find an instruction to block the chosen rock.
-                for (auto &p : m_rocks_blocking_instructions[rock_id])
+                int border = std::uniform_int_distribution<int>(0, level.width + 2*level.height - 1)(m_random);
+                std::pair<Vector2i,int> rock;
+
+                if (border < level.width)
                 {
-                    if (p.first > (int)p.second.size()) // If the instruction is still executable by acting on a tile ahead of the current rock tile.
-                    {
-                        instruction = &p.second.front();
-                        
-                        if (!instruction->tile->containsPlayer()) 
-                        {
-                            bool is_player_path = m_player_path->find(instruction->tile->getPosition()) != m_player_path->end();
-                        
-                            if (is_player_path)
-                            {
-                                 instruction->tile->unlock();
-                            }
-                            
-                            switch (instruction->action)
-                            {
-                                case ROTATE_LEFT:
-                                    action_str = "LEFT";
-                                    break;
-                                case ROTATE_RIGHT:
-                                    action_str = "RIGHT";
-                                    break;
-                            }
-                    
-                            cout << instruction->tile->getPosition().x << " " << instruction->tile->getPosition().y << " " << action_str << endl;
-                            
-                            p.second.pop();
-                                            
-                            if (is_player_path)
-                            {
-                                 instruction->tile->lock();
-                            }
-                            
-                            if (p.second.size() == 0)
-                            {
-                                m_rocks_safety[rock_id] = true;
-                                m_rocks_blocking_instructions.erase(rock_id);
-                                m_rocks_priorities.erase(rock_id);
-                            }
-                            
-                            has_moved_tile = true;         
-                            break;
-                        }
-                    }
+                    rock = make_pair(Vector2i(border, 0), (int)Direction::TOP);
                 }
-                
-                if (has_moved_tile)
+                else if ((border - level.width) % 2 == 0)
                 {
-                    return true;
+                    rock = make_pair(Vector2i(0, (border - level.width)/2), (int)Direction::LEFT);
                 }
                 else
                 {
-                    return false;
+                    rock = make_pair(Vector2i(level.width-1, (border - level.width)/2), (int)Direction::RIGHT);
+                }
+
+                bool free_tile = !(rock.first == player);
+
+                for (const std::pair<Vector2i,int> &other : rocks)
+                {
+                    free_tile = free_tile && !(other.first == rock.first);
+                }
+
+                if (free_tile && hasInput(level.types[rock.first.y*level.width + rock.first.x], rock.second))
+                {
+                    rocks.push_back(rock);
                 }
-            }
-            else
-            {
-                return false;
             }
         }
-    
-    private :
-        Map* m_map; // Level map.
-        std::unordered_map<Vector2i,PathNode> *m_player_path; // Pointer to player path.
-        
-        // Associative container rock_id => priority . Priorities corresponds to the farther tile we can act on to block the rock. 
-        //
-        // For example a priority of 1 tells that the rock can only be blocked by the tile 1 PathNode away from it, which means that 
-        // we must block it right now, otherwise we won't be able to block it.
-        // 
-        // Priorities can be negative if the last possible blocking tile for a rock has been exceeded, which is bad news and can
-        // indicate a bug in the algorithm.
-        unordered_map<int, int> m_rocks_priorities; 
-        
-        // Associative container rock_id => bool. 
-        // Contains TRUE for a rock_id if the rock is already blocked.
-        // Contains FALSE for a rock_id if the rock can still reach player path.
-        unordered_map<int, bool> m_rocks_safety;
-        
-        // Associative container rock_id => instructions to block it.
-        // Instructions are stored for each tile that can block the rock, starting from it starting tile.
-        // They are stored in a vector that associates the tile priority (identical in meaning to m_rocks_safety priorities), to a queue
-        // that contains instructions to execute on the tile to block the rock.
-        unordered_map<int, vector<pair<int, queue<SolverInstruction>>>> m_rocks_blocking_instructions;
-        
-        // Associative container rock_id => current path node.
-        unordered_map<int, PathNode> m_rocks_current_node;
+
+        std::mt19937 &m_random;
+        int m_max_turns;
 };
 
+/**
+ * @returns The given percentile of sorted values.
+ */
+double getPercentile(const std::vector<double> &sorted_values, double percentile)
+{
+    if (sorted_values.empty())
+    {
+        return 0.0;
+    }
+
+    return sorted_values[min(sorted_values.size()-1, (size_t)(percentile*sorted_values.size()))];
+}
+
+/**
+ * Portfolio benchmark : the first path of the same generated levels is searched by the SEQUENTIAL mode, then by the
+ * portfolio modes with 1, 2, 4 and 8 threads, and the wall clock speedups over SEQUENTIAL are reported. Usage :
+ *      ./referee solvers [levels] [seed] [width] [height] [lock density]
+ *
+ * @param[in] argc Arguments count, the "solvers" keyword included.
+ * @param[in] argv Arguments, the "solvers" keyword included.
+ *
+ * @returns The program exit code.
+ **/
+int benchmarkSolvers(int argc, char** argv)
+{
+    int levels_count = argc > 2 ? atoi(argv[2]) : 20;
+    unsigned seed = argc > 3 ? (unsigned)atoi(argv[3]) : 0;
+    int width = argc > 4 ? atoi(argv[4]) : 20;
+    int height = argc > 5 ? atoi(argv[5]) : 20;
+    double lock_density = argc > 6 ? atof(argv[6]) : 0.25;
+
+    static const int threads_counts[4] = {1, 2, 4, 8};
+    std::vector<Level> levels;
+
+    for (int k = 0; k < levels_count; k++)
+    {
+        std::mt19937 random(seed + k);
+        LevelGenerator generator(random);
+        levels.push_back(generator.generate(width, height, lock_density));
+    }
+
+    // Total search time of all the levels, and levels left without a path, for a mode and a threads count.
+    auto solve_levels = [&levels](PathSolverMode mode, int threads_count, int &failures) -> double
+    {
+        std::vector<SolverInstruction> instructions;
+        std::unordered_map<Vector2i,PathNode> final_path;
+        std::streambuf* error_output = cerr.rdbuf();
+        double total_ms = 0.0;
+        failures = 0;
+
+        for (const Level &level : levels)
+        {
+            Map level_map(level.width, level.height);
+            loadLevel(level, level_map);
+            PathSolver solver(&level_map, mode, threads_count);
+
+            cerr.rdbuf(nullptr); // the solver logs are muted.
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            solver.resolvePathToExit(level.start_x, 0, Direction::TOP, instructions, final_path);
+            total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            cerr.rdbuf(error_output);
+            cerr.clear();
+
+            failures += final_path.empty() ? 1 : 0;
+        }
+
+        return total_ms;
+    };
+
+    int failures = 0;
+    double sequential_ms = solve_levels(PathSolverMode::SEQUENTIAL, 0, failures);
+
+    cout << levels_count << " levels " << width << "x" << height << ", " << std::thread::hardware_concurrency() << " hardware thread(s)" << endl;
+    cout << "SEQUENTIAL: " << sequential_ms << " ms, " << failures << " without path" << endl;
+
+    for (PathSolverMode mode : {PathSolverMode::PORTFOLIO, PathSolverMode::DETERMINISTIC_PORTFOLIO})
+    {
+        for (int threads_count : threads_counts)
+        {
+            double mode_ms = solve_levels(mode, threads_count, failures);
+
+            cout << (mode == PathSolverMode::PORTFOLIO ? "PORTFOLIO" : "DETERMINISTIC_PORTFOLIO") << " " << threads_count << " thread(s): "
+                 << mode_ms << " ms, speedup x" << (mode_ms > 0.0 ? sequential_ms / mode_ms : 0.0) << ", " << failures << " without path" << endl;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Stress benchmark entry point.
+ **/
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "solvers")
+    {
+        return benchmarkSolvers(argc, argv);
+    }
+
+    int games = argc > 1 ? atoi(argv[1]) : 1000;
+    unsigned seed = argc > 2 ? (unsigned)atoi(argv[2]) : 0;
+    int width = argc > 3 ? atoi(argv[3]) : 0;
+    int height = argc > 4 ? atoi(argv[4]) : 0;
+    double lock_density = argc > 5 ? atof(argv[5]) : 0.25;
+    double rock_rate = argc > 6 ? atof(argv[6]) : -1.0;
+    bool corridors = argc > 7 && atoi(argv[7]) != 0;
+
+    static const char* outcome_names[5] = {"WIN", "LOSE", "ROCK", "ILLEGAL", "TIMEOUT"};
+    static const double rock_rates[4] = {0.0, 0.15, 0.3, 0.5};
+    int outcomes[5] = {0, 0, 0, 0, 0};
+    std::vector<double> first_turn_latencies, turn_latencies, game_latencies;
+    std::vector<int> rock_counts;
+    std::vector<double> load_latencies;
+    long long load_allocations = 0, loaded_tiles = 0;
+    std::streambuf* error_output = cerr.rdbuf();
+
+    for (int game = 0; game < games; game++)
+    {
+        std::mt19937 random(seed + game);
+        std::uniform_int_distribution<int> size_distribution(4, 13);
+        int game_width = width > 0 ? width : size_distribution(random);
+        int game_height = height > 0 ? height : size_distribution(random);
+        double game_rock_rate = rock_rate >= 0.0 ? rock_rate : rock_rates[std::uniform_int_distribution<int>(0, 3)(random)];
+
+        LevelGenerator generator(random);
+        OfflineReferee referee(random, 200);
+        Level level = generator.generate(game_width, game_height, lock_density, corridors);
+
+        cerr.rdbuf(nullptr); // the controller logs are muted during games.
+        game_latencies.clear();
+        double load_latency = 0.0;
+        long long game_load_allocations = 0;
+        GameOutcome outcome = referee.play(level, game_rock_rate, game_latencies, rock_counts, load_latency, game_load_allocations);
+        cerr.rdbuf(error_output);
+        cerr.clear();
+
+        load_latencies.push_back(load_latency);
+        load_allocations += game_load_allocations;
+        loaded_tiles += game_width * (game_height + 1); // exit line included
+
+        outcomes[outcome]++;
+        first_turn_latencies.push_back(game_latencies.front());
+        turn_latencies.insert(turn_latencies.end(), game_latencies.begin()+1, game_latencies.end());
+    }
+
+    sort(first_turn_latencies.begin(), first_turn_latencies.end());
+    sort(turn_latencies.begin(), turn_latencies.end());
+    sort(load_latencies.begin(), load_latencies.end());
+
+    for (int k = 0; k < 5; k++)
+    {
+        cout << outcome_names[k] << " " << outcomes[k] << endl;
+    }
+
+    cout << "Solve rate: " << (games > 0 ? 100.0*outcomes[GameOutcome::WIN]/games : 0.0) << "%" << endl;
+    cout << "First turn (ms): p50 " << getPercentile(first_turn_latencies, 0.5) << " p90 " << getPercentile(first_turn_latencies, 0.9)
+         << " p99 " << getPercentile(first_turn_latencies, 0.99) << " max " << getPercentile(first_turn_latencies, 1.0) << endl;
+    cout << "Other turns (ms): p50 " << getPercentile(turn_latencies, 0.5) << " p90 " << getPercentile(turn_latencies, 0.9)
+         << " p99 " << getPercentile(turn_latencies, 0.99) << " max " << getPercentile(turn_latencies, 1.0) << endl;
+    cout << "Map load: " << (loaded_tiles > 0 ? (double)load_allocations / loaded_tiles : 0.0) << " allocations per tile, p50 "
+         << getPercentile(load_latencies, 0.5) << " ms max " << getPercentile(load_latencies, 1.0) << " ms" << endl;
+    cout << "Rocks per turn: mean " << (rock_counts.empty() ? 0.0 : (double)accumulate(rock_counts.begin(), rock_counts.end(), 0LL) / rock_counts.size())
+         << " max " << (rock_counts.empty() ? 0 : *max_element(rock_counts.begin(), rock_counts.end())) << endl;
+
+    return 0;
+}
+#else
 
 /**
  * Auto-generated code below aims at helping you parse
@@ -1584,7 +6158,7 @@ int main()
     int H; // number of rows.
     int currentType;
     cin >> W >> H; cin.ignore();
-    Map level_map;
+    Map level_map(W, H);
     TileType t;
     string token; // token in a parsed line.
     istringstream iss; // string stream to parse every line
@@ -1712,33 +6286,15 @@ int main()
     int EX; // the coordinate along the X axis of the exit (not useful for this first mission, but must be read).
     cin >> EX; cin.ignore();
 
-    for (int k = 0; k < W; k++)
-    {
-        if (k == EX)
-        {
-            level_map.addTile(k, H, TileType::EXIT); // creates a new tile in the map.
-        }
-        else
-        {
-            level_map.addTile(k, H, TileType::TYPE0); // creates a new tile in the map.
-        }
-    }
+    level_map.addExitLine(EX);
+
     // ========================================================================
     //                              GAME LOOP
     // ========================================================================
 
-
-    PathSolver solver(&level_map);
-    std::vector<SolverInstruction> instructions;
-    std::unordered_map<Vector2i,PathNode> final_player_path;
-    std::unordered_set<Vector2i> safe_rock_tiles;
-    SolverInstruction loop_instruction;
-    bool solved = false;
-    Direction player_dir;
-    Tile* previous_tile = nullptr;
-    Tile* current_tile = nullptr;
-    
-    RockManager rock_manager(&level_map, &final_player_path);
+    TurnController controller(&level_map);
+    SolverInstruction instruction;
+    vector<PathNode> rocks;
 
     int XI;
     int YI;
@@ -1750,166 +6306,32 @@ int main()
     int YR;
     string POSR;
 
-    int instruction_index = 0;
-    string action_str;
-    
-    std::map<pair<Vector2i,int>, pair<Direction,int>> rocks;
-    Direction rock_dir;
-    int player_advancement = 0;
-
     // game loop
     while (1)
     {
-        // ======================== PLAYER POS UPDATE ==========================   
         cin >> XI >> YI >> POSI; cin.ignore();
-        
-        if (previous_tile != nullptr)
-        {
-            previous_tile->setContainsPlayer(false);
-        }
-        
-        current_tile = level_map.getTileAt(XI,YI);
-        
-        if (current_tile != nullptr)
-        {
-            current_tile->setContainsPlayer(true);
-        }
-        
-        player_advancement++;
-        // =====================================================================
-        
-        // ============================ PATH FINDING ===========================  
-        // (executed once only)
-        if (!solved)
-        {
-            if (POSI == "TOP")
-            {
-                player_dir = Direction::TOP;
-            }
-            else if (POSI == "BOTTOM")
-            {
-                player_dir = Direction::BOTTOM;
-            }
-            else if (POSI == "LEFT")
-            {
-                player_dir = Direction::LEFT;
-            }
-            else if (POSI == "RIGHT")
-            {
-                player_dir = Direction::RIGHT;
-            }
-
-            solver.resolvePathToExit(XI,YI,player_dir, instructions, final_player_path);
-
-            solved = true;
-        }
-        // =====================================================================
-        
-        
-        // ============================ ROCKS UPDATE ===========================  
+        LAST_CRUSADE_PHASE_BEGIN(); // The first line is mostly waiting for the referee.
         cin >> R; cin.ignore();
+
         rocks.clear();
-        
-        rock_manager.updateRocksAhead();
 
-        bool can_insert = true;
-        
-        for (int i = 0; i < R; i++) 
+        for (int i = 0; i < R; i++)
         {
-
             cin >> XR >> YR >> POSR; cin.ignore();
-            
-             if (POSR == "TOP")
-            {
-                rock_dir = Direction::TOP;
-            }
-            else if (POSR == "BOTTOM")
-            {
-                rock_dir = Direction::BOTTOM;
-            }
-            else if (POSR == "LEFT")
-            {
-                rock_dir = Direction::LEFT;
-            }
-            else if (POSR == "RIGHT")
-            {
-                rock_dir = Direction::RIGHT;
-            }
-                      
-            Vector2i rock_pos(XR,YR);
-            
-            if (final_player_path.find(rock_pos) == final_player_path.end())
-            {
-                rock_manager.processRock(XR, YR, rock_dir);
-            }
+
+            rocks.push_back(PathNode(level_map.getTileAt(XR,YR), TurnController::parseDirection(POSR)));
         }
-        // =====================================================================
 
-        // ====================== INSTRUCTION DECISION ========================= 
-        
-        if (instruction_index < instructions.size())
-        {            
-            bool has_loop_instruction = false;
-            
-            // Try to find the next instruction to construct player path
-            while (instruction_index < instructions.size() && !has_loop_instruction)
-            {
-                loop_instruction = instructions[instruction_index];
+        LAST_CRUSADE_PHASE_END(INPUT_PARSING);
 
-                // Sometimes player path tiles are locked by rock blocking algorithm when needed.
-                // But when it arrives, we are sure that the tile is already well placed.
-                if (!loop_instruction.tile->isLocked()) 
-                {
-                    has_loop_instruction = true;
-                }
-                else
-                {
-                    instruction_index++;
-                }
-            }
-            
-            
-            bool has_write_for_rock = false;
-            
-            // If we don't have an instruction to execute on player path or the instruction is not urgent.
-            // Then we check if we can take the opportunity to block a rock.
-            if (!has_loop_instruction || loop_instruction.path_position > player_advancement)
-            {
-                // Attempt to block a rock on the map
-                has_write_for_rock = rock_manager.processRockInterception();
-            }
-            
-            // If we have an instruction to execute on player path that is urgent, or we haven't found 
-            // any rock to block.
-            if (has_loop_instruction && !has_write_for_rock)
-            {
-                switch (loop_instruction.action)
-                {
-                    case ROTATE_LEFT:
-                        action_str = "LEFT";
-                        break;
-                    case ROTATE_RIGHT:
-                        action_str = "RIGHT";
-                        break;
-                }
-    
-                // Solving player path
-                cout << loop_instruction.tile->getPosition().x << " " << loop_instruction.tile->getPosition().y << " " << action_str << endl;
-    
-                instruction_index++;
-            }
-            else if (!has_write_for_rock)
-            {
-                cout << "WAIT" << endl;
-            }
+        if (controller.playTurn(XI, YI, TurnController::parseDirection(POSI), rocks, instruction))
+        {
+            cout << instruction.tile->getPosition().x << " " << instruction.tile->getPosition().y << " " << (instruction.action == TileAction::ROTATE_LEFT ? "LEFT" : "RIGHT") << endl;
         }
         else
         {
             cout << "WAIT" << endl;
         }
-        
-        // =====================================================================
-
-        previous_tile = current_tile;
     }
-}
\ No newline at end of file
+}
+#endif